@@ -10,6 +10,8 @@ INCLUDEPATH += \
     ../PluginFramework/include \
     ../Updater/include
 QMAKE_CXXFLAGS += -std=c++11
+# Keep message locations in release builds, the log rate limits per location
+DEFINES += QT_MESSAGELOGCONTEXT
 UI_DIR = ui
 
 CONFIG(release, release|debug){
@@ -32,6 +34,10 @@ CONFIG(debug, debug|release){
     MOC_DIR = moc/debug
 }
 
+# qmake CONFIG+=alloc_profiling counts heap allocations by subsystem and plugin
+alloc_profiling:DEFINES += SS_ALLOC_PROFILING
+alloc_profiling:!linux:error("alloc_profiling replaces malloc, which needs glibc")
+
 win32:RC_FILE = resources/mainicon.rc
 
 DESTDIR = $$OUT_PWD/../../build
@@ -47,7 +53,27 @@ SOURCES += \
     src/PreferencesDialog.cpp \
     src/WiiKeyManager.cpp \
     src/ApplicationLog.cpp \
-    src/OutputStreamMonitor.cpp
+    src/OutputStreamMonitor.cpp \
+    src/SearchService.cpp \
+    src/SearchDock.cpp \
+    src/SettingsStore.cpp \
+    src/PageCacheWarmer.cpp \
+    src/SingleInstance.cpp \
+    src/LogBuffer.cpp \
+    src/LogModel.cpp \
+    src/LogQueue.cpp \
+    src/LogWriter.cpp \
+    src/LogFilter.cpp \
+    src/LogIndex.cpp \
+    src/Metrics.cpp \
+    src/PerformanceDialog.cpp \
+    src/PluginUsage.cpp \
+    src/Tracer.cpp \
+    src/Watchdog.cpp \
+    src/SessionRecorder.cpp \
+    src/StartupProfile.cpp \
+    src/AllocationProfiler.cpp \
+    src/BatchExportDialog.cpp
 
 HEADERS += \
     include/Constants.hpp \
@@ -58,14 +84,39 @@ HEADERS += \
     include/PreferencesDialog.hpp \
     include/WiiKeyManager.hpp \
     include/ApplicationLog.hpp \
-    include/OutputStreamMonitor.hpp
+    include/OutputStreamMonitor.hpp \
+    include/SearchService.hpp \
+    include/SearchDock.hpp \
+    include/SearchDecoderInterface.hpp \
+    include/SettingsStore.hpp \
+    include/PageCacheWarmer.hpp \
+    include/SingleInstance.hpp \
+    include/LogBuffer.hpp \
+    include/LogModel.hpp \
+    include/LogQueue.hpp \
+    include/LogWriter.hpp \
+    include/LogFilter.hpp \
+    include/LogIndex.hpp \
+    include/Metrics.hpp \
+    include/PerformanceDialog.hpp \
+    include/PluginUsage.hpp \
+    include/Tracer.hpp \
+    include/TraceInterface.hpp \
+    include/Watchdog.hpp \
+    include/SessionRecorder.hpp \
+    include/StartupProfile.hpp \
+    include/AllocationProfiler.hpp \
+    include/BatchExportDialog.hpp
 
 FORMS += \
     ui/MainWindow.ui \
     ui/PluginsDialog.ui \
     ui/AboutDialog.ui \
     ui/PreferencesDialog.ui \
-    ui/ApplicationLog.ui
+    ui/ApplicationLog.ui \
+    ui/SearchDock.ui \
+    ui/PerformanceDialog.ui \
+    ui/BatchExportDialog.ui
 
 RESOURCES += \
     resources/resources.qrc
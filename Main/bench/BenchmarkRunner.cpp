@@ -0,0 +1,357 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+
+#include "BenchmarkRunner.hpp"
+#include "Constants.hpp"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSettings>
+#include <QSysInfo>
+#include <QThread>
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+
+namespace
+{
+const int DefaultSamples = 10;
+const int DefaultMinimumTime = 50; // msecs
+
+// Nearest rank on sorted samples
+double quantile(const QList<double>& samples, double q)
+{
+    int rank = (int)ceil(q * samples.size()) - 1;
+    return samples.at(qBound(0, rank, samples.size() - 1));
+}
+
+QString describe(const QString& name, const QVariantMap& parameters)
+{
+    QStringList parts(name);
+    for (QVariantMap::const_iterator it = parameters.constBegin(); it != parameters.constEnd(); ++it)
+        parts << QString("%1=%2").arg(it.key()).arg(it.value().toString());
+
+    return parts.join(' ');
+}
+
+void messageHandler(QtMsgType type, const QMessageLogContext& context, const QString& message)
+{
+    Q_UNUSED(context);
+    if (type != QtDebugMsg)
+        fprintf(stderr, "%s\n", qPrintable(message));
+}
+}
+
+BenchmarkRunner::BenchmarkRunner()
+    : m_samples(DefaultSamples),
+      m_minimumTime(DefaultMinimumTime * 1000000ll),
+      m_list(false)
+{
+}
+
+bool BenchmarkRunner::setUpSandbox(const QTemporaryDir& sandbox, const QString& applicationName)
+{
+    if (!sandbox.isValid())
+    {
+        fprintf(stderr, "Unable to create a temporary directory\n");
+        return false;
+    }
+
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    qputenv("SAKURASUITE_LOG_PATH", QFile::encodeName(sandbox.path()));
+
+    // Every run starts from empty settings, and the user's own are left alone
+    const QString settingsPath = QDir(sandbox.path()).filePath("settings");
+    QSettings::setDefaultFormat(QSettings::IniFormat);
+    QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, settingsPath);
+    QSettings::setPath(QSettings::IniFormat, QSettings::SystemScope, settingsPath);
+
+    QCoreApplication::setOrganizationName("org.wiiking2.com");
+    QCoreApplication::setApplicationName(applicationName);
+    return true;
+}
+
+void BenchmarkRunner::installMessageHandler()
+{
+    qInstallMessageHandler(messageHandler);
+}
+
+void BenchmarkRunner::addOption(const QCommandLineOption& option)
+{
+    m_options << option;
+}
+
+bool BenchmarkRunner::parseArguments(const QStringList& arguments)
+{
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    foreach (const QCommandLineOption& option, m_options)
+        parser.addOption(option);
+    QCommandLineOption filterOption("filter", "Only run benchmarks whose name matches <regexp>.", "regexp");
+    QCommandLineOption samplesOption("samples", "Samples to take of every benchmark.", "n", QString::number(DefaultSamples));
+    QCommandLineOption minimumTimeOption("min-time", "Minimum length of a sample in milliseconds.", "ms", QString::number(DefaultMinimumTime));
+    QCommandLineOption outputOption("output", "Write the JSON results to <file> instead of stdout.", "file");
+    QCommandLineOption listOption("list", "List the benchmarks instead of running them.");
+    parser.addOption(filterOption);
+    parser.addOption(samplesOption);
+    parser.addOption(minimumTimeOption);
+    parser.addOption(outputOption);
+    parser.addOption(listOption);
+
+    if (!parser.parse(arguments))
+    {
+        fprintf(stderr, "%s\n", qPrintable(parser.errorText()));
+        return false;
+    }
+
+    if (parser.isSet("help"))
+    {
+        fprintf(stdout, "%s", qPrintable(parser.helpText()));
+        return false;
+    }
+
+    m_filter = QRegularExpression(parser.value(filterOption));
+    if (!m_filter.isValid())
+    {
+        fprintf(stderr, "Invalid filter: %s\n", qPrintable(m_filter.errorString()));
+        return false;
+    }
+
+    m_samples = qMax(1, parser.value(samplesOption).toInt());
+    m_minimumTime = qMax(1, parser.value(minimumTimeOption).toInt()) * 1000000ll;
+    m_output = parser.value(outputOption);
+    m_list = parser.isSet(listOption);
+    foreach (const QCommandLineOption& option, m_options)
+    {
+        if (parser.isSet(option) || !option.defaultValues().isEmpty())
+            m_values[option.names().first()] = parser.value(option);
+    }
+
+    return true;
+}
+
+bool BenchmarkRunner::isSet(const QString& option) const
+{
+    return m_values.contains(option);
+}
+
+QString BenchmarkRunner::value(const QString& option) const
+{
+    return m_values.value(option);
+}
+
+int BenchmarkRunner::samples() const
+{
+    return m_samples;
+}
+
+bool BenchmarkRunner::isSelected(const QString& name) const
+{
+    return m_filter.match(name).hasMatch();
+}
+
+double BenchmarkRunner::measure(const Body& body, qint64 iterations) const
+{
+    QElapsedTimer timer;
+    timer.start();
+    body(iterations);
+    return (double)timer.nsecsElapsed() / iterations;
+}
+
+void BenchmarkRunner::run(const QString& name, const QVariantMap& parameters, const Body& body)
+{
+    if (!isSelected(name))
+        return;
+
+    if (m_list)
+    {
+        fprintf(stdout, "%s\n", qPrintable(describe(name, parameters)));
+        return;
+    }
+
+    // Also warms up the caches and whatever the body creates lazily
+    qint64 iterations = 1;
+    forever
+    {
+        QElapsedTimer timer;
+        timer.start();
+        body(iterations);
+        qint64 elapsed = timer.nsecsElapsed();
+        if (elapsed >= m_minimumTime)
+            break;
+
+        // Aim a little past the minimum time, but never grow more than tenfold at once
+        double estimate = elapsed > 0 ? iterations * (m_minimumTime * 1.2 / elapsed) : iterations * 10.0;
+        iterations = qBound(iterations + 1, (qint64)estimate, iterations * 10);
+    }
+
+    Result result;
+    result.name = name;
+    result.parameters = parameters;
+    result.iterations = iterations;
+    for (int i = 0; i < m_samples; i++)
+        result.samples << measure(body, iterations);
+
+    report(result);
+    m_results << result;
+}
+
+void BenchmarkRunner::runOnce(const QString& name, const QVariantMap& parameters, const Body& body)
+{
+    if (!isSelected(name))
+        return;
+
+    if (m_list)
+    {
+        fprintf(stdout, "%s\n", qPrintable(describe(name, parameters)));
+        return;
+    }
+
+    Result result;
+    result.name = name;
+    result.parameters = parameters;
+    result.iterations = 1;
+    for (int i = 0; i < m_samples; i++)
+        result.samples << measure(body, 1);
+
+    report(result);
+    m_results << result;
+}
+
+void BenchmarkRunner::record(const QString& name, const QVariantMap& parameters, const QList<double>& samples)
+{
+    if (m_list || samples.isEmpty())
+        return;
+
+    Result result;
+    result.name = name;
+    result.parameters = parameters;
+    result.iterations = 1;
+    result.samples = samples;
+    report(result);
+    m_results << result;
+}
+
+void BenchmarkRunner::report(const Result& result) const
+{
+    QList<double> samples = result.samples;
+    std::sort(samples.begin(), samples.end());
+    fprintf(stderr, "%-60s %14.1f ns (min %.1f, max %.1f)\n", qPrintable(describe(result.name, result.parameters)),
+            samples.at(samples.size() / 2), samples.first(), samples.last());
+}
+
+void BenchmarkRunner::setSummary(const QString& key, const QVariant& value)
+{
+    m_summary[key] = value;
+}
+
+const QList<BenchmarkRunner::Result>& BenchmarkRunner::results() const
+{
+    return m_results;
+}
+
+QByteArray BenchmarkRunner::toJson(const QString& suite) const
+{
+    QJsonArray results;
+    foreach (const Result& result, m_results)
+    {
+        QList<double> samples = result.samples;
+        std::sort(samples.begin(), samples.end());
+
+        double sum = 0;
+        QJsonArray rawSamples;
+        foreach (double sample, result.samples)
+        {
+            sum += sample;
+            rawSamples.append(sample);
+        }
+        double mean = sum / samples.size();
+        double variance = 0;
+        foreach (double sample, samples)
+            variance += (sample - mean) * (sample - mean);
+
+        QJsonObject nsPerOp;
+        nsPerOp["min"] = samples.first();
+        nsPerOp["median"] = samples.at(samples.size() / 2);
+        nsPerOp["p90"] = quantile(samples, 0.9);
+        nsPerOp["p99"] = quantile(samples, 0.99);
+        nsPerOp["mean"] = mean;
+        nsPerOp["max"] = samples.last();
+        nsPerOp["stddev"] = sqrt(variance / samples.size());
+
+        QJsonObject object;
+        object["name"] = result.name;
+        object["parameters"] = QJsonObject::fromVariantMap(result.parameters);
+        object["iterations"] = (double)result.iterations;
+        object["ns_per_op"] = nsPerOp;
+        object["samples"] = rawSamples;
+        results.append(object);
+    }
+
+    QJsonObject context;
+    context["version"] = Constants::SAKURASUITE_APP_VERSION;
+    context["qt"] = QString(qVersion());
+    context["os"] = QSysInfo::prettyProductName();
+    context["cpu"] = QSysInfo::currentCpuArchitecture();
+    context["threads"] = QThread::idealThreadCount();
+    context["date"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+#ifdef SS_DEBUG
+    context["build"] = QString("debug");
+#else
+    context["build"] = QString("release");
+#endif
+
+    QJsonObject root;
+    root["suite"] = suite;
+    root["context"] = context;
+    root["results"] = results;
+    if (!m_summary.isEmpty())
+        root["summary"] = QJsonObject::fromVariantMap(m_summary);
+    return QJsonDocument(root).toJson();
+}
+
+bool BenchmarkRunner::write(const QString& suite) const
+{
+    if (m_list)
+        return true;
+
+    QFile file;
+    bool opened;
+    if (m_output.isEmpty())
+    {
+        opened = file.open(stdout, QFile::WriteOnly);
+    }
+    else
+    {
+        file.setFileName(m_output);
+        opened = file.open(QFile::WriteOnly | QFile::Truncate);
+    }
+
+    if (!opened)
+    {
+        fprintf(stderr, "Unable to write %s: %s\n", qPrintable(m_output), qPrintable(file.errorString()));
+        return false;
+    }
+
+    return file.write(toJson(suite)) >= 0;
+}
@@ -0,0 +1,107 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+
+#ifndef BENCHMARKRUNNER_HPP
+#define BENCHMARKRUNNER_HPP
+
+#include <QCommandLineOption>
+#include <QList>
+#include <QMap>
+#include <QRegularExpression>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QVariantMap>
+#include <functional>
+
+// Runs benchmarks and writes their results as JSON so runs of different
+// builds can be compared. A benchmark body is told how many iterations to
+// run, the runner picks a count that takes at least the minimum time and
+// then takes several samples of it.
+class BenchmarkRunner
+{
+public:
+    typedef std::function<void (qint64 iterations)> Body;
+
+    struct Result
+    {
+        QString     name;
+        QVariantMap parameters;
+        qint64      iterations;
+        // Nanoseconds per iteration of each sample
+        QList<double> samples;
+    };
+
+    BenchmarkRunner();
+
+    // Call before QApplication is constructed. Picks the offscreen platform unless
+    // another was asked for and keeps the log and the INI settings in sandbox,
+    // so a benchmark never touches the user's editor or sees its settings.
+    static bool setUpSandbox(const QTemporaryDir& sandbox, const QString& applicationName);
+    // Keeps debug output out of the results, warnings and errors go to stderr
+    static void installMessageHandler();
+
+    // Options of the benchmark itself, added before parseArguments()
+    void addOption(const QCommandLineOption& option);
+    // --filter <regexp>, --samples <n>, --min-time <ms>, --output <file>, --list
+    // and the added options
+    bool parseArguments(const QStringList& arguments);
+    bool isSet(const QString& option) const;
+    QString value(const QString& option) const;
+    int samples() const;
+    bool isSelected(const QString& name) const;
+
+    void run(const QString& name, const QVariantMap& parameters, const Body& body);
+    // Runs body exactly once per sample, for things too slow to repeat
+    void runOnce(const QString& name, const QVariantMap& parameters, const Body& body);
+    // Adds samples measured by the caller, in nanoseconds per operation
+    void record(const QString& name, const QVariantMap& parameters, const QList<double>& samples);
+
+    // Anything else the benchmark found out, written next to the results
+    void setSummary(const QString& key, const QVariant& value);
+
+    const QList<Result>& results() const;
+    QByteArray toJson(const QString& suite) const;
+    // To the --output file, or stdout
+    bool write(const QString& suite) const;
+
+    // Stops the compiler from optimizing value away
+    template <typename T>
+    static void keep(const T& value)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "g"(&value) : "memory");
+#else
+        static const void* volatile sink;
+        sink = &value;
+#endif
+    }
+
+private:
+    double measure(const Body& body, qint64 iterations) const;
+    void report(const Result& result) const;
+
+    QList<QCommandLineOption> m_options;
+    QMap<QString, QString>    m_values;
+    QRegularExpression m_filter;
+    int                m_samples;
+    qint64             m_minimumTime; // nsecs
+    QString            m_output;
+    bool               m_list;
+    QList<Result>      m_results;
+    QVariantMap        m_summary;
+};
+
+#endif // BENCHMARKRUNNER_HPP
@@ -0,0 +1,317 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+
+
+// sakurasuite_plugin_conformance, measures a plugin's loader and saver.
+// Loads the plugin the way the editor does, then round trips every file of a
+// corpus the plugin accepts through loadFile and save, one at a time on the GUI
+// thread like the editor does, or on --jobs threads for reentrant plugins,
+// --samples times, and compares what was saved with the original byte for byte.
+// Reports load, save and round trip latency per file, corpus throughput, peak
+// memory, and every round trip that didn't reproduce the file, exiting with 2 then.
+
+#include "BenchmarkRunner.hpp"
+#include "ApplicationLog.hpp"
+#include "MainWindow.hpp"
+#include "PluginsManager.hpp"
+#include <PluginInterface.hpp>
+#include <DocumentBase.hpp>
+#include <QApplication>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QTemporaryDir>
+#include <QThreadPool>
+#include <QVector>
+#include <algorithm>
+#include <stdio.h>
+
+#if defined(Q_OS_LINUX) || defined(Q_OS_MAC)
+#include <sys/resource.h>
+#elif defined(Q_OS_WIN)
+#define PSAPI_VERSION 2
+#include <windows.h>
+#include <psapi.h>
+#endif
+
+namespace
+{
+struct RoundTrip
+{
+    QString file;
+    qint64  size;
+    // Nanoseconds, of the last pass
+    qint64  load;
+    qint64  save;
+    QString failure;
+};
+
+// Peak resident set of the whole process in bytes, -1 if unknown
+qint64 peakMemory()
+{
+#if defined(Q_OS_LINUX) || defined(Q_OS_MAC)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage))
+        return -1;
+#ifdef Q_OS_MAC
+    return usage.ru_maxrss;
+#else
+    return (qint64)usage.ru_maxrss * 1024;
+#endif
+#elif defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return -1;
+    return counters.PeakWorkingSetSize;
+#else
+    return -1;
+#endif
+}
+
+class RoundTripTask : public QRunnable
+{
+public:
+    RoundTripTask(PluginInterface* plugin, RoundTrip* roundTrip, const QString& output)
+        : m_plugin(plugin),
+          m_roundTrip(roundTrip),
+          m_output(output)
+    {
+    }
+
+    void run()
+    {
+        RoundTrip& roundTrip = *m_roundTrip;
+        roundTrip.failure.clear();
+        roundTrip.load = roundTrip.save = 0;
+
+        QFile original(roundTrip.file);
+        if (!original.open(QFile::ReadOnly))
+        {
+            roundTrip.failure = QString("Unable to read the file: %1").arg(original.errorString());
+            return;
+        }
+        const QByteArray expected = original.readAll();
+
+        QElapsedTimer timer;
+        timer.start();
+        DocumentBase* document = m_plugin->loadFile(roundTrip.file);
+        roundTrip.load = timer.nsecsElapsed();
+        if (!document)
+        {
+            roundTrip.failure = "loadFile failed";
+            return;
+        }
+
+        timer.restart();
+        bool saved = document->save(m_output);
+        roundTrip.save = timer.nsecsElapsed();
+        delete document;
+        if (!saved)
+        {
+            roundTrip.failure = "save failed";
+            return;
+        }
+
+        QFile result(m_output);
+        if (!result.open(QFile::ReadOnly))
+        {
+            roundTrip.failure = QString("Unable to read what was saved: %1").arg(result.errorString());
+            return;
+        }
+        const QByteArray actual = result.readAll();
+        result.close();
+        QFile::remove(m_output);
+
+        if (actual != expected)
+        {
+            int offset = 0;
+            const int common = qMin(actual.size(), expected.size());
+            while (offset < common && actual.at(offset) == expected.at(offset))
+                offset++;
+            roundTrip.failure = QString("Saved %1 bytes of %2, first difference at offset 0x%3")
+                                    .arg(actual.size()).arg(expected.size()).arg(offset, 0, 16);
+        }
+    }
+
+private:
+    PluginInterface* m_plugin;
+    RoundTrip*       m_roundTrip;
+    QString          m_output;
+};
+}
+
+int main(int argc, char* argv[])
+{
+    QTemporaryDir sandbox;
+    if (!BenchmarkRunner::setUpSandbox(sandbox, "sakurasuite_plugin_conformance"))
+        return 1;
+
+    // The plugin under test is the only plugin
+    QDir dir(sandbox.path());
+    dir.mkpath("plugins");
+    dir.mkpath("output");
+    qputenv("SAKURASUITE_PLUGIN_PATH", QFile::encodeName(dir.absoluteFilePath("plugins")));
+
+    QApplication app(argc, argv);
+
+    BenchmarkRunner runner;
+    runner.addOption(QCommandLineOption("plugin", "The plugin library to test.", "file"));
+    runner.addOption(QCommandLineOption("corpus", "Directory of files to round trip, searched recursively.", "directory"));
+    // More than one job calls loadFile, save and the document's destructor on
+    // several pool threads at once, only plugins that are reentrant and don't
+    // touch widgets there can be measured that way.
+    runner.addOption(QCommandLineOption("jobs", "Files round tripped at once on worker threads, only for reentrant plugins.",
+                                        "n", "1"));
+    if (!runner.parseArguments(app.arguments()))
+        return 1;
+
+    if (!runner.isSet("plugin") || !runner.isSet("corpus"))
+    {
+        fprintf(stderr, "Both --plugin and --corpus are required\n");
+        return 1;
+    }
+
+    ApplicationLog::instance();
+    BenchmarkRunner::installMessageHandler();
+
+    MainWindow window;
+    PluginsManager* manager = window.pluginsManager();
+    if (!manager->loadPlugin(QFileInfo(runner.value("plugin")).absoluteFilePath()) || manager->plugins().isEmpty())
+        return 1;
+    PluginInterface* plugin = manager->plugins().first();
+
+    // Asked up front, on this thread, canLoad is cheap and may not be reentrant
+    QVector<RoundTrip> roundTrips;
+    int skipped = 0;
+    qint64 corpusSize = 0;
+    QDirIterator it(runner.value("corpus"), QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext())
+    {
+        QString file = it.next();
+        if (!plugin->canLoad(file))
+        {
+            skipped++;
+            continue;
+        }
+
+        RoundTrip roundTrip;
+        roundTrip.file = file;
+        roundTrip.size = it.fileInfo().size();
+        roundTrip.load = roundTrip.save = 0;
+        roundTrips << roundTrip;
+        corpusSize += roundTrip.size;
+    }
+
+    if (roundTrips.isEmpty())
+    {
+        fprintf(stderr, "%s accepts none of the files in %s\n", qPrintable(plugin->name()), qPrintable(runner.value("corpus")));
+        return 1;
+    }
+
+    const int jobs = qMax(1, runner.value("jobs").toInt());
+    QThreadPool pool;
+    pool.setMaxThreadCount(jobs);
+
+    QVariantMap parameters;
+    parameters["plugin"] = plugin->name();
+    parameters["files"] = roundTrips.count();
+    parameters["jobs"] = jobs;
+
+    const qint64 baseMemory = peakMemory();
+    QList<double> loads;
+    QList<double> saves;
+    QList<double> totals;
+    QList<double> passes;
+    QMap<QString, QString> failures;
+    for (int pass = 0; pass < runner.samples(); pass++)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < roundTrips.count(); i++)
+        {
+            // Saved next to each other under the original name, plugins may look at the extension
+            QString output = dir.absoluteFilePath(QString("output/%1/%2").arg(i).arg(QFileInfo(roundTrips.at(i).file).fileName()));
+            dir.mkpath(QFileInfo(output).absolutePath());
+            RoundTripTask* task = new RoundTripTask(plugin, &roundTrips[i], output);
+            if (jobs > 1)
+            {
+                pool.start(task);
+            }
+            else
+            {
+                task->run();
+                delete task;
+            }
+        }
+        pool.waitForDone();
+        passes << timer.nsecsElapsed();
+
+        foreach (const RoundTrip& roundTrip, roundTrips)
+        {
+            if (!roundTrip.failure.isEmpty())
+            {
+                failures[roundTrip.file] = roundTrip.failure;
+                continue;
+            }
+
+            loads << roundTrip.load;
+            saves << roundTrip.save;
+            totals << roundTrip.load + roundTrip.save;
+        }
+    }
+
+    runner.record("loadFile", parameters, loads);
+    runner.record("save", parameters, saves);
+    runner.record("round trip", parameters, totals);
+    runner.record("corpus", parameters, passes);
+
+    // From the median pass, every byte was loaded once and saved once
+    QList<double> sorted = passes;
+    std::sort(sorted.begin(), sorted.end());
+    const double megabytesPerSecond = (corpusSize / 1e6) / (sorted.at(sorted.size() / 2) / 1e9);
+    const qint64 peak = peakMemory();
+
+    QVariantList mismatches;
+    QMapIterator<QString, QString> failure(failures);
+    while (failure.hasNext())
+    {
+        failure.next();
+        fprintf(stderr, "%s: %s\n", qPrintable(failure.key()), qPrintable(failure.value()));
+        QVariantMap mismatch;
+        mismatch["file"] = failure.key();
+        mismatch["reason"] = failure.value();
+        mismatches << mismatch;
+    }
+
+    fprintf(stderr, "%d files, %.1f MB, %.1f MB/s, peak memory %.1f MB (%+.1f MB), %d skipped, %d failed\n",
+            roundTrips.count(), corpusSize / 1e6, megabytesPerSecond, peak / 1e6, (peak - baseMemory) / 1e6,
+            skipped, failures.count());
+
+    runner.setSummary("files", roundTrips.count());
+    runner.setSummary("skipped", skipped);
+    runner.setSummary("bytes", (double)corpusSize);
+    runner.setSummary("megabytesPerSecond", megabytesPerSecond);
+    runner.setSummary("peakMemory", (double)peak);
+    runner.setSummary("peakMemoryGrowth", (double)(peak - baseMemory));
+    runner.setSummary("mismatches", mismatches);
+
+    if (!runner.write("sakurasuite_plugin_conformance"))
+        return 1;
+    return failures.isEmpty() ? 0 : 2;
+}
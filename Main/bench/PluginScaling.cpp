@@ -0,0 +1,219 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+
+// sakurasuite_plugin_bench, measures how the plugin system scales.
+// Generates sets of N synthetic plugin libraries and, for every N, measures
+// starting the main window with them, picking the plugin for a file and
+// opening a file. With --generate it only writes a plugin set and exits.
+
+#include "BenchmarkRunner.hpp"
+#include "SyntheticPlugin.hpp"
+#include "ApplicationLog.hpp"
+#include "MainWindow.hpp"
+#include "Metrics.hpp"
+#include "PluginsManager.hpp"
+#include <QApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QTemporaryDir>
+#include <math.h>
+#include <stdio.h>
+
+// Set by the build to the library it builds next to this benchmark
+#ifndef SS_SYNTHETIC_PLUGIN
+#define SS_SYNTHETIC_PLUGIN ""
+#endif
+
+namespace
+{
+struct PluginSet
+{
+    int     count;
+    double  overlap;
+    SyntheticPlugin::Config config;
+
+    // Plugins share extensions in groups, so the more overlap the fewer distinct extensions
+    int extensions() const
+    {
+        return qMax(1, (int)floor(count * (1.0 - overlap) + 0.5));
+    }
+
+    // Only the plugins of the last group accept it, so most plugins get probed first
+    QString lastExtension() const
+    {
+        return QString("syn%1").arg(extensions() - 1);
+    }
+};
+
+bool generate(const PluginSet& set, const QString& library, const QString& directory)
+{
+    QDir dir(directory);
+    if (!dir.mkpath("."))
+    {
+        fprintf(stderr, "Unable to create %s\n", qPrintable(directory));
+        return false;
+    }
+
+    const QString suffix = QFileInfo(library).suffix();
+    for (int i = 0; i < set.count; i++)
+    {
+        // Zero padded, plugins are loaded in directory order
+        QString path = dir.absoluteFilePath(QString("synthetic%1.%2").arg(i, 5, 10, QChar('0')).arg(suffix));
+        QFile::remove(path);
+        if (!QFile::copy(library, path))
+        {
+            fprintf(stderr, "Unable to copy %s to %s\n", qPrintable(library), qPrintable(path));
+            return false;
+        }
+
+        SyntheticPlugin::Config config = set.config;
+        config.name = QString("Synthetic%1").arg(i);
+        config.extension = QString("syn%1").arg(i % set.extensions());
+
+        QFile file(path + ".json");
+        if (!file.open(QFile::WriteOnly | QFile::Truncate) || file.write(QJsonDocument(config.toJson()).toJson()) < 0)
+        {
+            fprintf(stderr, "Unable to write %s\n", qPrintable(file.fileName()));
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void measure(BenchmarkRunner& runner, const PluginSet& set, const QString& pluginPath, const QString& document)
+{
+    QVariantMap parameters;
+    parameters["plugins"] = set.count;
+    parameters["overlap"] = set.overlap;
+    parameters["initializeUsecs"] = set.config.initializeUsecs;
+    parameters["canLoadUsecs"] = set.config.canLoadUsecs;
+    parameters["loadUsecs"] = set.config.loadUsecs;
+    parameters["documentSize"] = (double)set.config.documentSize;
+
+    qputenv("SAKURASUITE_PLUGIN_PATH", QFile::encodeName(pluginPath));
+
+    // Every sample starts a new main window, which loads all the plugins
+    QList<double> startup;
+    QList<double> loadPlugins;
+    MainWindow* window = NULL;
+    for (int i = 0; i < runner.samples(); i++)
+    {
+        delete window;
+        Metrics::instance()->reset();
+        QElapsedTimer timer;
+        timer.start();
+        window = new MainWindow;
+        startup << timer.nsecsElapsed();
+        loadPlugins << Metrics::instance()->histogram("sakurasuite_load_plugins_seconds")->sum() * 1000.0;
+    }
+
+    runner.record("MainWindow startup", parameters, startup);
+    runner.record("PluginsManager::loadPlugins", parameters, loadPlugins);
+
+    if (window->pluginsManager()->plugins().count() != set.count)
+        fprintf(stderr, "Only %d of %d plugins were loaded\n", window->pluginsManager()->plugins().count(), set.count);
+
+    PluginsManager* manager = window->pluginsManager();
+    runner.run("PluginsManager::preferredPlugin", parameters, [&](qint64 iterations)
+    {
+        for (qint64 i = 0; i < iterations; i++)
+            BenchmarkRunner::keep(manager->preferredPlugin(document));
+    });
+
+    runner.run("MainWindow::openFile", parameters, [&](qint64 iterations)
+    {
+        for (qint64 i = 0; i < iterations; i++)
+        {
+            window->openFiles(QStringList(document));
+            QMetaObject::invokeMethod(window, "onClose", Qt::DirectConnection);
+        }
+    });
+
+    delete window;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    QTemporaryDir sandbox;
+    if (!BenchmarkRunner::setUpSandbox(sandbox, "sakurasuite_plugin_bench"))
+        return 1;
+
+    QApplication app(argc, argv);
+
+    BenchmarkRunner runner;
+    runner.addOption(QCommandLineOption("plugins", "Comma separated plugin counts.", "counts", "1,10,50,100,200"));
+    runner.addOption(QCommandLineOption("overlap", "Fraction of plugins that share their extension with another, 0 to 1.", "fraction", "0"));
+    runner.addOption(QCommandLineOption("init-us", "Microseconds every plugin spends in initialize.", "usecs", "0"));
+    runner.addOption(QCommandLineOption("can-load-us", "Microseconds every canLoad takes.", "usecs", "0"));
+    runner.addOption(QCommandLineOption("load-us", "Microseconds every loadFile takes.", "usecs", "0"));
+    runner.addOption(QCommandLineOption("document-size", "Bytes every document allocates.", "bytes", "0"));
+    runner.addOption(QCommandLineOption("library", "The synthetic plugin library to copy.", "file", SS_SYNTHETIC_PLUGIN));
+    runner.addOption(QCommandLineOption("generate", "Only write a set of the first plugin count to <directory>.", "directory"));
+    if (!runner.parseArguments(app.arguments()))
+        return 1;
+
+    ApplicationLog::instance();
+    BenchmarkRunner::installMessageHandler();
+
+    PluginSet set;
+    set.overlap = qBound(0.0, runner.value("overlap").toDouble(), 1.0);
+    set.config.initializeUsecs = runner.value("init-us").toInt();
+    set.config.canLoadUsecs = runner.value("can-load-us").toInt();
+    set.config.loadUsecs = runner.value("load-us").toInt();
+    set.config.documentSize = runner.value("document-size").toLongLong();
+
+    QList<int> counts;
+    foreach (const QString& count, runner.value("plugins").split(',', QString::SkipEmptyParts))
+        counts << qMax(1, count.trimmed().toInt());
+    if (counts.isEmpty())
+        return 1;
+
+    const QString library = runner.value("library");
+    if (!QFileInfo(library).isFile())
+    {
+        fprintf(stderr, "Synthetic plugin library %s not found, see --library\n", qPrintable(library));
+        return 1;
+    }
+
+    if (runner.isSet("generate"))
+    {
+        set.count = counts.first();
+        return generate(set, library, runner.value("generate")) ? 0 : 1;
+    }
+
+    foreach (int count, counts)
+    {
+        set.count = count;
+        const QString pluginPath = QString("%1/plugins%2").arg(sandbox.path()).arg(count);
+        if (!generate(set, library, pluginPath))
+            return 1;
+
+        // The file needs to exist, the main window watches it for changes
+        const QString document = QString("%1/level.%2").arg(sandbox.path()).arg(set.lastExtension());
+        QFile file(document);
+        file.open(QFile::WriteOnly);
+        file.close();
+
+        measure(runner, set, pluginPath, document);
+    }
+
+    return runner.write("sakurasuite_plugin_bench") ? 0 : 1;
+}
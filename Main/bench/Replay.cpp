@@ -0,0 +1,146 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+
+
+// sakurasuite_replay, measures the latency users see.
+// Replays a session recorded with SAKURASUITE_RECORD_SESSION=<file> against
+// copies of the files it touched, --samples times, and reports how long every
+// kind of action took until the event loop was idle again.
+
+#include "BenchmarkRunner.hpp"
+#include "SessionReplay.hpp"
+#include "ApplicationLog.hpp"
+#include "MainWindow.hpp"
+#include "PluginsManager.hpp"
+#include <QApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <stdio.h>
+
+namespace
+{
+// Copies every file of the session below directory, so saves don't touch the originals
+bool copyFiles(const QStringList& files, const QString& dataPath, const QString& directory, QMap<QString, QString>& paths)
+{
+    QDir dir(directory);
+    if (dir.exists() && !dir.removeRecursively())
+    {
+        fprintf(stderr, "Unable to clean %s\n", qPrintable(directory));
+        return false;
+    }
+
+    QDir data(dataPath);
+    foreach (const QString& file, files)
+    {
+        QString source = data.absoluteFilePath(file);
+        // Files outside the data directory were recorded with their absolute path
+        QString relative = QDir::isAbsolutePath(file) ? QString("external/%1").arg(QString(file).remove(':')) : file;
+        QString target = QDir::cleanPath(dir.absoluteFilePath(relative));
+        paths[file] = target;
+
+        if (!QFileInfo(source).isFile())
+        {
+            fprintf(stderr, "%s not found, its actions are skipped\n", qPrintable(source));
+            continue;
+        }
+
+        if (!QDir().mkpath(QFileInfo(target).absolutePath()) || !QFile::copy(source, target))
+        {
+            fprintf(stderr, "Unable to copy %s to %s\n", qPrintable(source), qPrintable(target));
+            return false;
+        }
+    }
+
+    return true;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    QTemporaryDir sandbox;
+    if (!BenchmarkRunner::setUpSandbox(sandbox, "sakurasuite_replay"))
+        return 1;
+
+    QApplication app(argc, argv);
+
+    BenchmarkRunner runner;
+    runner.addOption(QCommandLineOption("script", "The recorded session to replay.", "file"));
+    runner.addOption(QCommandLineOption("data", "Directory the session's relative paths are in, defaults to the script's.", "directory"));
+    runner.addOption(QCommandLineOption("plugins", "Directory to load plugins from.", "directory"));
+    runner.addOption(QCommandLineOption("realtime", "Keep the recorded pauses between actions."));
+    if (!runner.parseArguments(app.arguments()))
+        return 1;
+
+    if (!runner.isSet("script"))
+    {
+        fprintf(stderr, "No session given, see --script\n");
+        return 1;
+    }
+
+    if (runner.isSet("plugins"))
+        qputenv("SAKURASUITE_PLUGIN_PATH", QFile::encodeName(runner.value("plugins")));
+
+    ApplicationLog::instance();
+    BenchmarkRunner::installMessageHandler();
+
+    const QString script = runner.value("script");
+    const QString dataPath = runner.isSet("data") ? runner.value("data") : QFileInfo(script).absolutePath();
+
+    MainWindow window;
+    SessionReplay replay(&window);
+    QString error;
+    if (!replay.load(script, &error))
+    {
+        fprintf(stderr, "Unable to read %s: %s\n", qPrintable(script), qPrintable(error));
+        return 1;
+    }
+
+    QList<double> sessions;
+    for (int i = 0; i < runner.samples(); i++)
+    {
+        QMap<QString, QString> paths;
+        if (!copyFiles(replay.files(), dataPath, QString("%1/data").arg(sandbox.path()), paths))
+            return 1;
+
+        QElapsedTimer timer;
+        timer.start();
+        replay.play(paths, runner.isSet("realtime"));
+        sessions << timer.nsecsElapsed();
+    }
+
+    if (replay.skipped())
+        fprintf(stderr, "%d actions were skipped, their files couldn't be opened\n", replay.skipped());
+    if (replay.dialogs())
+        fprintf(stderr, "%d dialogs were dismissed\n", replay.dialogs());
+
+    QVariantMap parameters;
+    parameters["script"] = QFileInfo(script).fileName();
+    parameters["plugins"] = window.pluginsManager()->plugins().count();
+    parameters["realtime"] = runner.isSet("realtime");
+
+    QMapIterator<QString, QList<double> > it(replay.latencies());
+    while (it.hasNext())
+    {
+        it.next();
+        runner.record(it.key(), parameters, it.value());
+    }
+
+    runner.record("session", parameters, sessions);
+    return runner.write("sakurasuite_replay") ? 0 : 1;
+}
@@ -0,0 +1,243 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+
+#include "SessionReplay.hpp"
+#include "MainWindow.hpp"
+#include <DocumentBase.hpp>
+#include <QApplication>
+#include <QDialog>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMessageBox>
+#include <QPushButton>
+
+namespace
+{
+// How often to look for dialogs while playing
+const int DialogInterval = 20;
+}
+
+SessionReplay::SessionReplay(MainWindow* window)
+    : m_window(window),
+      m_dialogs(0),
+      m_skipped(0)
+{
+    m_dialogTimer.setInterval(DialogInterval);
+    connect(&m_dialogTimer, SIGNAL(timeout()), this, SLOT(dismissDialogs()));
+}
+
+bool SessionReplay::load(const QString& script, QString* error)
+{
+    QFile file(script);
+    if (!file.open(QFile::ReadOnly | QFile::Text))
+    {
+        if (error)
+            *error = file.errorString();
+        return false;
+    }
+
+    m_actions.clear();
+    int lineNumber = 0;
+    while (!file.atEnd())
+    {
+        QByteArray line = file.readLine().trimmed();
+        lineNumber++;
+        if (line.isEmpty())
+            continue;
+
+        QJsonParseError parseError;
+        QJsonObject object = QJsonDocument::fromJson(line, &parseError).object();
+        if (parseError.error != QJsonParseError::NoError)
+        {
+            if (error)
+                *error = QString("Line %1: %2").arg(lineNumber).arg(parseError.errorString());
+            return false;
+        }
+
+        Action action;
+        action.time = (qint64)object.value("t").toDouble();
+        action.action = object.value("action").toString();
+        action.file = object.value("file").toString();
+        action.to = object.value("to").toString();
+        action.count = qMax(1, object.value("count").toInt());
+        if (!action.file.isEmpty())
+            m_actions << action;
+    }
+
+    return true;
+}
+
+const QList<SessionReplay::Action>& SessionReplay::actions() const
+{
+    return m_actions;
+}
+
+QStringList SessionReplay::files() const
+{
+    QStringList files;
+    QStringList created;
+    foreach (const Action& action, m_actions)
+    {
+        if (!files.contains(action.file) && !created.contains(action.file))
+            files << action.file;
+        if (action.action == "saveAs" && !files.contains(action.to))
+            created << action.to;
+    }
+
+    return files;
+}
+
+void SessionReplay::play(const QMap<QString, QString>& paths, bool realtime)
+{
+    m_dialogTimer.start();
+    QMap<QString, QString> targets = paths;
+    QElapsedTimer clock;
+    clock.start();
+    foreach (const Action& action, m_actions)
+    {
+        const QString path = targets.value(action.file, action.file);
+        if (action.action == "saveAs" && !targets.contains(action.to))
+        {
+            // Kept apart from the copies, it may have the same name as one
+            QDir dir(QString("%1/saved-as/%2").arg(QFileInfo(path).absolutePath()).arg(targets.count()));
+            dir.mkpath(".");
+            targets[action.to] = QDir::cleanPath(dir.absoluteFilePath(QFileInfo(action.to).fileName()));
+        }
+
+        // The pause isn't part of any action
+        if (realtime && action.time > clock.elapsed())
+        {
+            QEventLoop loop;
+            QTimer::singleShot((int)(action.time - clock.elapsed()), &loop, SLOT(quit()));
+            loop.exec();
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        if (perform(action, path, targets.value(action.to)))
+        {
+            settle();
+            m_latencies[action.action] << (double)timer.nsecsElapsed();
+        }
+        else
+        {
+            m_skipped++;
+        }
+    }
+
+    // Leave the window as it was found, without saving anything
+    QMetaObject::invokeMethod(m_window, "onCloseAll", Qt::DirectConnection);
+    m_dialogTimer.stop();
+}
+
+bool SessionReplay::perform(const Action& action, const QString& path, const QString& to)
+{
+    if (action.action == "open")
+    {
+        m_window->openFiles(QStringList(path));
+        return m_window->document(path) != NULL;
+    }
+
+    DocumentBase* document = m_window->document(path);
+    if (!document)
+        return false;
+
+    if (action.action == "switch")
+        return m_window->activateDocument(path);
+
+    if (action.action == "edit")
+    {
+        // What the plugin changed can't be replayed, but everything
+        // listening to the document can be made to react to it
+        for (int i = 0; i < action.count; i++)
+            QMetaObject::invokeMethod(document, "modified", Qt::DirectConnection);
+        return true;
+    }
+
+    if (action.action == "save")
+    {
+        // Replayed edits don't make the document dirty, and the window only saves dirty documents
+        m_window->activateDocument(path);
+        if (document->isDirty())
+            QMetaObject::invokeMethod(m_window, "onSave", Qt::DirectConnection);
+        else
+            document->save();
+        return true;
+    }
+
+    if (action.action == "saveAs")
+    {
+        m_window->activateDocument(path);
+        return m_window->saveCurrentAs(to);
+    }
+
+    if (action.action == "reload" || action.action == "close")
+    {
+        m_window->activateDocument(path);
+        QMetaObject::invokeMethod(m_window, action.action == "reload" ? "onReload" : "onClose", Qt::DirectConnection);
+        return true;
+    }
+
+    return false;
+}
+
+void SessionReplay::settle()
+{
+    // Runs whatever the action queued, like the log drain or deferred updates
+    QCoreApplication::sendPostedEvents();
+    QCoreApplication::processEvents(QEventLoop::AllEvents);
+}
+
+void SessionReplay::dismissDialogs()
+{
+    QWidget* modal = QApplication::activeModalWidget();
+    if (!modal)
+        return;
+
+    m_dialogs++;
+    QMessageBox* messageBox = qobject_cast<QMessageBox*>(modal);
+    if (messageBox && messageBox->button(QMessageBox::Discard))
+    {
+        messageBox->button(QMessageBox::Discard)->click();
+        return;
+    }
+
+    QDialog* dialog = qobject_cast<QDialog*>(modal);
+    if (dialog)
+        dialog->reject();
+    else
+        modal->close();
+}
+
+const QMap<QString, QList<double> >& SessionReplay::latencies() const
+{
+    return m_latencies;
+}
+
+int SessionReplay::dialogs() const
+{
+    return m_dialogs;
+}
+
+int SessionReplay::skipped() const
+{
+    return m_skipped;
+}
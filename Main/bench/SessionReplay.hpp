@@ -0,0 +1,78 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+
+#ifndef SESSIONREPLAY_HPP
+#define SESSIONREPLAY_HPP
+
+#include <QObject>
+#include <QList>
+#include <QMap>
+#include <QStringList>
+#include <QTimer>
+
+class MainWindow;
+
+// Plays a script written by SessionRecorder against a main window and
+// measures every action until the event loop has caught up with it.
+// Dialogs the actions open are dismissed, discarding changes, and counted.
+class SessionReplay : public QObject
+{
+    Q_OBJECT
+public:
+    struct Action
+    {
+        qint64  time;
+        QString action;
+        QString file;
+        // Where a saveAs saved the document to
+        QString to;
+        int     count;
+    };
+
+    explicit SessionReplay(MainWindow* window);
+
+    bool load(const QString& script, QString* error = 0);
+    const QList<Action>& actions() const;
+    // Every file the script refers to that the session didn't create by saving
+    // a document under a new path, as written in the script
+    QStringList files() const;
+
+    // paths maps the files in the script to the copies to use, files saved
+    // under a new path that aren't in it are saved next to their document.
+    // With realtime the recorded pauses between actions are kept.
+    void play(const QMap<QString, QString>& paths, bool realtime);
+
+    // Nanoseconds each action took, by action
+    const QMap<QString, QList<double> >& latencies() const;
+    int dialogs() const;
+    int skipped() const;
+
+private slots:
+    void dismissDialogs();
+
+private:
+    bool perform(const Action& action, const QString& path, const QString& to);
+    void settle();
+
+    MainWindow*   m_window;
+    QList<Action> m_actions;
+    QMap<QString, QList<double> > m_latencies;
+    QTimer        m_dialogTimer;
+    int           m_dialogs;
+    int           m_skipped;
+};
+
+#endif // SESSIONREPLAY_HPP
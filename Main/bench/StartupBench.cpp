@@ -0,0 +1,248 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+
+
+// sakurasuite_startup_bench, measures startup as the user sees it.
+// Launches the editor with SAKURASUITE_STARTUP_PROFILE set, --samples times
+// per configuration, and reports the time from starting the process to
+// main, to the main window being constructed, to its first showEvent and
+// to the first time the event loop goes idle. Configurations are with and
+// without plugins, each with a warm and a cold page cache.
+
+#include "BenchmarkRunner.hpp"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <chrono>
+#include <stdio.h>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Set by the build to the editor it builds next to this benchmark
+#ifndef SS_SAKURASUITE
+#define SS_SAKURASUITE ""
+#endif
+
+namespace
+{
+// Generous, a cold start on a slow disk can take a while
+const int LaunchTimeout = 120000;
+
+// The milestones StartupProfile records, in order, with the names they're reported as
+const char* const Milestones[][2] =
+{
+    {"main",       "process start to main"},
+    {"mainWindow", "process start to MainWindow constructed"},
+    {"showEvent",  "time to first paint"},
+    {"firstIdle",  "time to interactive"}
+};
+const int MilestoneCount = sizeof(Milestones) / sizeof(Milestones[0]);
+
+// Same clock as StartupProfile::now()
+qint64 now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+QStringList filesIn(const QString& directory)
+{
+    QStringList files;
+    foreach (const QFileInfo& info, QDir(directory).entryInfoList(QDir::Files))
+        files << info.absoluteFilePath();
+    return files;
+}
+
+// Returns how the page cache was dropped, empty if it couldn't be
+QString dropPageCache(const QStringList& files)
+{
+#ifdef Q_OS_LINUX
+    // Everything, but only root may
+    ::sync();
+    QFile dropCaches("/proc/sys/vm/drop_caches");
+    if (dropCaches.open(QFile::WriteOnly) && dropCaches.write("3\n") == 2 && dropCaches.flush())
+        return "drop_caches";
+
+    // Otherwise at least the editor's own files, the system libraries stay cached
+    foreach (const QString& file, files)
+    {
+        int fd = ::open(QFile::encodeName(file).constData(), O_RDONLY);
+        if (fd < 0)
+            continue;
+        ::fdatasync(fd);
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        ::close(fd);
+    }
+
+    return "fadvise";
+#else
+    Q_UNUSED(files);
+    return QString();
+#endif
+}
+
+// Returns the milestones in nanoseconds since the process was started, empty on failure
+QMap<QString, qint64> launch(const QString& application, const QProcessEnvironment& environment, const QString& profile)
+{
+    QFile::remove(profile);
+
+    QProcess process;
+    process.setProcessEnvironment(environment);
+    process.setStandardOutputFile(QProcess::nullDevice());
+    process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+
+    const qint64 launched = now();
+    process.start(application, QStringList());
+    if (!process.waitForFinished(LaunchTimeout))
+    {
+        fprintf(stderr, "%s didn't finish starting: %s\n", qPrintable(application), qPrintable(process.errorString()));
+        process.kill();
+        process.waitForFinished();
+        return QMap<QString, qint64>();
+    }
+
+    QFile file(profile);
+    if (!file.open(QFile::ReadOnly))
+    {
+        fprintf(stderr, "%s exited with %d without writing a startup profile\n", qPrintable(application), process.exitCode());
+        return QMap<QString, qint64>();
+    }
+
+    QMap<QString, qint64> milestones;
+    QJsonObject marks = QJsonDocument::fromJson(file.readAll()).object().value("marks").toObject();
+    foreach (const QString& mark, marks.keys())
+        milestones[mark] = (qint64)marks.value(mark).toDouble() - launched;
+
+    return milestones;
+}
+
+bool measure(BenchmarkRunner& runner, const QString& application, QProcessEnvironment environment,
+             const QString& pluginPath, bool cold, const QString& profile)
+{
+    environment.insert("SAKURASUITE_PLUGIN_PATH", pluginPath);
+    const QStringList plugins = filesIn(pluginPath);
+
+    QVariantMap parameters;
+    parameters["plugins"] = plugins.count();
+    parameters["cache"] = cold ? "cold" : "warm";
+
+    QStringList editorFiles = filesIn(QFileInfo(application).absolutePath()) + plugins;
+    if (cold)
+    {
+        QString method = dropPageCache(editorFiles);
+        if (method.isEmpty())
+        {
+            fprintf(stderr, "The page cache can't be dropped on this platform, skipping cold starts\n");
+            return true;
+        }
+
+        parameters["dropped"] = method;
+    }
+    else if (launch(application, environment, profile).isEmpty())
+    {
+        // Warms the cache, and checks the editor starts at all
+        return false;
+    }
+
+    QList<double> samples[MilestoneCount];
+    for (int i = 0; i < runner.samples(); i++)
+    {
+        if (cold)
+            dropPageCache(editorFiles);
+
+        QMap<QString, qint64> milestones = launch(application, environment, profile);
+        if (milestones.isEmpty())
+            return false;
+
+        for (int m = 0; m < MilestoneCount; m++)
+        {
+            if (milestones.contains(Milestones[m][0]))
+                samples[m] << (double)milestones.value(Milestones[m][0]);
+        }
+    }
+
+    for (int m = 0; m < MilestoneCount; m++)
+        runner.record(Milestones[m][1], parameters, samples[m]);
+
+    return true;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication::setOrganizationName("org.wiiking2.com");
+    QCoreApplication::setApplicationName("sakurasuite_startup_bench");
+    QCoreApplication app(argc, argv);
+
+    BenchmarkRunner runner;
+    runner.addOption(QCommandLineOption("app", "The editor to start.", "file", SS_SAKURASUITE));
+    runner.addOption(QCommandLineOption("plugins", "Also start with the plugins in <directory>.", "directory"));
+    runner.addOption(QCommandLineOption("cache", "Comma separated page cache states, warm and cold.", "states", "warm,cold"));
+    if (!runner.parseArguments(app.arguments()))
+        return 1;
+
+    const QString application = runner.value("app");
+    if (!QFileInfo(application).isExecutable())
+    {
+        fprintf(stderr, "Editor %s not found, see --app\n", qPrintable(application));
+        return 1;
+    }
+
+    QTemporaryDir sandbox;
+    if (!sandbox.isValid())
+    {
+        fprintf(stderr, "Unable to create a temporary directory\n");
+        return 1;
+    }
+
+    // A fresh home, so settings, the session and recent files of the user's editor don't interfere
+    QDir dir(sandbox.path());
+    dir.mkpath("home");
+    dir.mkpath("config");
+    dir.mkpath("log");
+    dir.mkpath("noplugins");
+
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    if (!environment.contains("QT_QPA_PLATFORM"))
+        environment.insert("QT_QPA_PLATFORM", "offscreen");
+    environment.insert("HOME", dir.absoluteFilePath("home"));
+    environment.insert("XDG_CONFIG_HOME", dir.absoluteFilePath("config"));
+    environment.insert("SAKURASUITE_LOG_PATH", dir.absoluteFilePath("log"));
+    environment.insert("SAKURASUITE_STARTUP_PROFILE", dir.absoluteFilePath("profile.json"));
+
+    QStringList pluginPaths(dir.absoluteFilePath("noplugins"));
+    if (runner.isSet("plugins"))
+        pluginPaths << QDir(runner.value("plugins")).absolutePath();
+
+    QStringList states = runner.value("cache").split(',', QString::SkipEmptyParts);
+    foreach (const QString& pluginPath, pluginPaths)
+    {
+        foreach (const QString& state, states)
+        {
+            if (!measure(runner, application, environment, pluginPath, state.trimmed() == "cold", dir.absoluteFilePath("profile.json")))
+                return 1;
+        }
+    }
+
+    return runner.write("sakurasuite_startup_bench") ? 0 : 1;
+}
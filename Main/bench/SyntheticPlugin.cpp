@@ -0,0 +1,214 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+
+#include "SyntheticPlugin.hpp"
+#include <QElapsedTimer>
+#include <QFile>
+
+SyntheticPlugin::Config::Config()
+    : name("Synthetic"),
+      extension("syn"),
+      initializeUsecs(0),
+      canLoadUsecs(0),
+      loadUsecs(0),
+      documentSize(0)
+{
+}
+
+SyntheticPlugin::Config SyntheticPlugin::Config::fromJson(const QJsonObject& object)
+{
+    Config config;
+    config.name = object.value("name").toString(config.name);
+    config.extension = object.value("extension").toString(config.extension);
+    config.initializeUsecs = object.value("initializeUsecs").toInt();
+    config.canLoadUsecs = object.value("canLoadUsecs").toInt();
+    config.loadUsecs = object.value("loadUsecs").toInt();
+    config.documentSize = (qint64)object.value("documentSize").toDouble();
+    return config;
+}
+
+QJsonObject SyntheticPlugin::Config::toJson() const
+{
+    QJsonObject object;
+    object["name"] = name;
+    object["extension"] = extension;
+    object["initializeUsecs"] = initializeUsecs;
+    object["canLoadUsecs"] = canLoadUsecs;
+    object["loadUsecs"] = loadUsecs;
+    object["documentSize"] = (double)documentSize;
+    return object;
+}
+
+SyntheticPlugin::SyntheticPlugin(const Config& config)
+    : m_config(config),
+      m_enabled(true)
+{
+}
+
+const SyntheticPlugin::Config& SyntheticPlugin::config() const
+{
+    return m_config;
+}
+
+void SyntheticPlugin::setConfig(const Config& config)
+{
+    m_config = config;
+}
+
+void SyntheticPlugin::initialize(MainWindowBase* mainWindow)
+{
+    Q_UNUSED(mainWindow);
+    spin(m_config.initializeUsecs);
+}
+
+QString SyntheticPlugin::filter() const
+{
+    return QString("%1 Files (*.%2)").arg(m_config.name).arg(m_config.extension);
+}
+
+QString SyntheticPlugin::extension() const
+{
+    return m_config.extension;
+}
+
+QString SyntheticPlugin::name() const
+{
+    return m_config.name;
+}
+
+QString SyntheticPlugin::author() const
+{
+    return QString("Sakura Suite");
+}
+
+QString SyntheticPlugin::version() const
+{
+    return QString("1.0");
+}
+
+QString SyntheticPlugin::website() const
+{
+    return QString();
+}
+
+QString SyntheticPlugin::description() const
+{
+    return tr("Synthetic plugin used to measure the plugin system");
+}
+
+QString SyntheticPlugin::license() const
+{
+    return QString("GPLv3");
+}
+
+QString SyntheticPlugin::path() const
+{
+    return m_path;
+}
+
+void SyntheticPlugin::setPath(const QString& path)
+{
+    m_path = path;
+}
+
+bool SyntheticPlugin::enabled() const
+{
+    return m_enabled;
+}
+
+void SyntheticPlugin::setEnabled(const bool enable)
+{
+    if (m_enabled == enable)
+        return;
+
+    m_enabled = enable;
+    emit enabledChanged();
+}
+
+bool SyntheticPlugin::canLoad(const QString& filename)
+{
+    spin(m_config.canLoadUsecs);
+    return filename.endsWith("." + m_config.extension, Qt::CaseInsensitive);
+}
+
+DocumentBase* SyntheticPlugin::loadFile(const QString& file) const
+{
+    spin(m_config.loadUsecs);
+    return new SyntheticDocument(this, file, m_config.documentSize);
+}
+
+bool SyntheticPlugin::hasUpdater() const
+{
+    return false;
+}
+
+void SyntheticPlugin::doUpdate()
+{
+}
+
+Updater* SyntheticPlugin::updater()
+{
+    return NULL;
+}
+
+PluginSettingsDialog* SyntheticPlugin::settingsDialog()
+{
+    return NULL;
+}
+
+QObject* SyntheticPlugin::object()
+{
+    return this;
+}
+
+QIcon SyntheticPlugin::icon() const
+{
+    return QIcon();
+}
+
+void SyntheticPlugin::spin(int usecs)
+{
+    if (usecs <= 0)
+        return;
+
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.nsecsElapsed() < usecs * 1000ll)
+        ;
+}
+
+SyntheticDocument::SyntheticDocument(const PluginInterface* loader, const QString& file, qint64 size)
+    : DocumentBase(loader, file),
+      m_data(size, '\0')
+{
+    // Touch every page so the memory is really committed
+    for (qint64 i = 0; i < size; i += 4096)
+        m_data[(int)i] = (char)i;
+}
+
+bool SyntheticDocument::save(const QString& filename)
+{
+    QFile file(filename.isEmpty() ? filePath() : filename);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate))
+        return false;
+
+    return file.write(m_data) == m_data.size();
+}
+
+bool SyntheticDocument::reload()
+{
+    return true;
+}
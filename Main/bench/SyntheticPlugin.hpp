@@ -0,0 +1,106 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+
+#ifndef SYNTHETICPLUGIN_HPP
+#define SYNTHETICPLUGIN_HPP
+
+#include <QObject>
+#include <QIcon>
+#include <QJsonObject>
+#include <PluginInterface.hpp>
+#include <DocumentBase.hpp>
+
+class MainWindowBase;
+class PluginSettingsDialog;
+class Updater;
+
+// A plugin that does nothing but take as long as it's told to, so the plugin
+// system can be measured with any number of plugins.
+class SyntheticPlugin : public QObject, public PluginInterface
+{
+    Q_OBJECT
+    Q_INTERFACES(PluginInterface)
+public:
+    struct Config
+    {
+        Config();
+        static Config fromJson(const QJsonObject& object);
+        QJsonObject toJson() const;
+
+        QString name;
+        // canLoad accepts files ending in ".<extension>"
+        QString extension;
+        int     initializeUsecs;
+        int     canLoadUsecs;
+        int     loadUsecs;
+        // Bytes every document allocates
+        qint64  documentSize;
+    };
+
+    explicit SyntheticPlugin(const Config& config = Config());
+
+    const Config& config() const;
+    void setConfig(const Config& config);
+
+    void initialize(MainWindowBase* mainWindow);
+    QString filter() const;
+    QString extension() const;
+    QString name() const;
+    QString author() const;
+    QString version() const;
+    QString website() const;
+    QString description() const;
+    QString license() const;
+    QString path() const;
+    void setPath(const QString& path);
+    bool enabled() const;
+    void setEnabled(const bool enable);
+    bool canLoad(const QString& filename);
+    DocumentBase* loadFile(const QString& file) const;
+    bool hasUpdater() const;
+    void doUpdate();
+    Updater* updater();
+    PluginSettingsDialog* settingsDialog();
+    QObject* object();
+    QIcon icon() const;
+
+    // Keeps the CPU busy, sleeping would let the OS hide the cost
+    static void spin(int usecs);
+
+signals:
+    void enabledChanged();
+    void newDocument(DocumentBase* document);
+
+private:
+    Config  m_config;
+    QString m_path;
+    bool    m_enabled;
+};
+
+class SyntheticDocument : public DocumentBase
+{
+    Q_OBJECT
+public:
+    SyntheticDocument(const PluginInterface* loader, const QString& file, qint64 size);
+
+    bool save(const QString& filename = QString());
+    bool reload();
+
+private:
+    QByteArray m_data;
+};
+
+#endif // SYNTHETICPLUGIN_HPP
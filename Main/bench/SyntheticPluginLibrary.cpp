@@ -0,0 +1,38 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+
+#include "SyntheticPluginLibrary.hpp"
+#include <QFile>
+#include <QJsonDocument>
+#include <QDebug>
+
+SyntheticPluginLibrary::SyntheticPluginLibrary()
+{
+}
+
+void SyntheticPluginLibrary::setPath(const QString& path)
+{
+    SyntheticPlugin::setPath(path);
+
+    QFile file(path + ".json");
+    if (!file.open(QFile::ReadOnly))
+    {
+        qWarning() << "Unable to read the synthetic plugin config" << file.fileName();
+        return;
+    }
+
+    setConfig(Config::fromJson(QJsonDocument::fromJson(file.readAll()).object()));
+}
@@ -0,0 +1,36 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+
+#ifndef SYNTHETICPLUGINLIBRARY_HPP
+#define SYNTHETICPLUGINLIBRARY_HPP
+
+#include "SyntheticPlugin.hpp"
+
+// SyntheticPlugin built as a plugin library. The generator copies the one
+// library once per plugin, every copy reads its Config from the JSON file
+// next to it (<library>.json) as soon as PluginsManager tells it its path.
+class SyntheticPluginLibrary : public SyntheticPlugin
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID PluginInterface_iid)
+    Q_INTERFACES(PluginInterface)
+public:
+    SyntheticPluginLibrary();
+
+    void setPath(const QString& path);
+};
+
+#endif // SYNTHETICPLUGINLIBRARY_HPP
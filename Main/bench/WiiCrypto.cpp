@@ -0,0 +1,728 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+
+#include "WiiCrypto.hpp"
+#include <QAtomicInt>
+#include <QStringList>
+#include <string.h>
+
+#if defined(Q_PROCESSOR_X86) && (defined(Q_CC_GNU) || defined(Q_CC_CLANG) || defined(Q_CC_MSVC))
+#define SS_CRYPTO_X86
+#include <immintrin.h>
+#ifdef Q_CC_MSVC
+#include <intrin.h>
+#define SS_TARGET(features)
+#else
+#include <cpuid.h>
+#define SS_TARGET(features) __attribute__((target(features)))
+#endif
+#endif
+
+namespace
+{
+const int AesRounds = 10;
+const int RoundKeysSize = (AesRounds + 1) * WiiCrypto::AesBlockSize;
+
+typedef void (*AesCbcKernel)(const quint8 roundKeys[RoundKeysSize], quint8 iv[16], const quint8* in, quint8* out, size_t blocks);
+typedef void (*Sha1Kernel)(quint32 state[5], const quint8* data, size_t blocks);
+
+// Portable AES
+
+struct AesTables
+{
+    AesTables()
+    {
+        // Inverses in GF(2^8) through log tables of generator 3, followed by the affine transform
+        quint8 exp[256];
+        quint8 log[256];
+        quint8 x = 1;
+        for (int i = 0; i < 255; i++)
+        {
+            exp[i] = x;
+            log[x] = (quint8)i;
+            x ^= (quint8)((x << 1) ^ ((x & 0x80) ? 0x1B : 0));
+        }
+
+        for (int i = 0; i < 256; i++)
+        {
+            quint8 inverse = i ? exp[(255 - log[i]) % 255] : 0;
+            quint8 s = inverse;
+            for (int j = 1; j < 5; j++)
+                s ^= (quint8)((inverse << j) | (inverse >> (8 - j)));
+            s ^= 0x63;
+            sbox[i] = s;
+            inverseSbox[s] = (quint8)i;
+        }
+    }
+
+    quint8 sbox[256];
+    quint8 inverseSbox[256];
+};
+
+const AesTables& aesTables()
+{
+    static const AesTables tables;
+    return tables;
+}
+
+inline quint8 xtime(quint8 x)
+{
+    return (quint8)((x << 1) ^ ((x & 0x80) ? 0x1B : 0));
+}
+
+inline void mixColumns(quint8 state[16])
+{
+    for (int c = 0; c < 16; c += 4)
+    {
+        quint8 a0 = state[c], a1 = state[c + 1], a2 = state[c + 2], a3 = state[c + 3];
+        quint8 all = a0 ^ a1 ^ a2 ^ a3;
+        state[c]     = a0 ^ all ^ xtime(a0 ^ a1);
+        state[c + 1] = a1 ^ all ^ xtime(a1 ^ a2);
+        state[c + 2] = a2 ^ all ^ xtime(a2 ^ a3);
+        state[c + 3] = a3 ^ all ^ xtime(a3 ^ a0);
+    }
+}
+
+void expandKey(const quint8 key[16], quint8 roundKeys[RoundKeysSize])
+{
+    const quint8* sbox = aesTables().sbox;
+    memcpy(roundKeys, key, 16);
+    quint8 rcon = 1;
+    for (int i = 16; i < RoundKeysSize; i += 4)
+    {
+        quint8 word[4] = {roundKeys[i - 4], roundKeys[i - 3], roundKeys[i - 2], roundKeys[i - 1]};
+        if (i % 16 == 0)
+        {
+            quint8 first = word[0];
+            word[0] = sbox[word[1]] ^ rcon;
+            word[1] = sbox[word[2]];
+            word[2] = sbox[word[3]];
+            word[3] = sbox[first];
+            rcon = xtime(rcon);
+        }
+
+        for (int j = 0; j < 4; j++)
+            roundKeys[i + j] = roundKeys[i - 16 + j] ^ word[j];
+    }
+}
+
+inline void addRoundKey(quint8 state[16], const quint8* roundKey)
+{
+    for (int i = 0; i < 16; i++)
+        state[i] ^= roundKey[i];
+}
+
+void encryptBlock(const quint8 roundKeys[RoundKeysSize], quint8 state[16])
+{
+    const quint8* sbox = aesTables().sbox;
+    addRoundKey(state, roundKeys);
+    for (int round = 1; round <= AesRounds; round++)
+    {
+        // SubBytes and ShiftRows, the state is column major
+        quint8 shifted[16];
+        for (int i = 0; i < 16; i++)
+            shifted[i] = sbox[state[(i + 4 * (i % 4)) % 16]];
+
+        memcpy(state, shifted, 16);
+        if (round != AesRounds)
+            mixColumns(state);
+
+        addRoundKey(state, roundKeys + round * 16);
+    }
+}
+
+void decryptBlock(const quint8 roundKeys[RoundKeysSize], quint8 state[16])
+{
+    const quint8* inverseSbox = aesTables().inverseSbox;
+    addRoundKey(state, roundKeys + AesRounds * 16);
+    for (int round = AesRounds - 1; round >= 0; round--)
+    {
+        // InvShiftRows and InvSubBytes
+        quint8 shifted[16];
+        for (int i = 0; i < 16; i++)
+            shifted[i] = inverseSbox[state[(i + 12 * (i % 4)) % 16]];
+
+        memcpy(state, shifted, 16);
+        addRoundKey(state, roundKeys + round * 16);
+        if (round == 0)
+            break;
+
+        // InvMixColumns is MixColumns after multiplying opposite bytes by 4
+        for (int c = 0; c < 16; c += 4)
+        {
+            quint8 u = xtime(xtime(state[c] ^ state[c + 2]));
+            quint8 v = xtime(xtime(state[c + 1] ^ state[c + 3]));
+            state[c]     ^= u;
+            state[c + 1] ^= v;
+            state[c + 2] ^= u;
+            state[c + 3] ^= v;
+        }
+        mixColumns(state);
+    }
+}
+
+void aesCbcEncryptPortable(const quint8 roundKeys[RoundKeysSize], quint8 iv[16], const quint8* in, quint8* out, size_t blocks)
+{
+    for (size_t i = 0; i < blocks; i++, in += 16, out += 16)
+    {
+        for (int j = 0; j < 16; j++)
+            iv[j] ^= in[j];
+        encryptBlock(roundKeys, iv);
+        memcpy(out, iv, 16);
+    }
+}
+
+void aesCbcDecryptPortable(const quint8 roundKeys[RoundKeysSize], quint8 iv[16], const quint8* in, quint8* out, size_t blocks)
+{
+    for (size_t i = 0; i < blocks; i++, in += 16, out += 16)
+    {
+        // in and out may be the same block
+        quint8 cipher[16];
+        quint8 state[16];
+        memcpy(cipher, in, 16);
+        memcpy(state, in, 16);
+        decryptBlock(roundKeys, state);
+        for (int j = 0; j < 16; j++)
+            out[j] = state[j] ^ iv[j];
+        memcpy(iv, cipher, 16);
+    }
+}
+
+// Portable SHA-1
+
+inline quint32 rotateLeft(quint32 x, int bits)
+{
+    return (x << bits) | (x >> (32 - bits));
+}
+
+void sha1Portable(quint32 state[5], const quint8* data, size_t blocks)
+{
+    for (; blocks; blocks--, data += 64)
+    {
+        quint32 w[80];
+        for (int i = 0; i < 16; i++)
+            w[i] = ((quint32)data[4 * i] << 24) | ((quint32)data[4 * i + 1] << 16) | ((quint32)data[4 * i + 2] << 8) | data[4 * i + 3];
+        for (int i = 16; i < 80; i++)
+            w[i] = rotateLeft(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+        quint32 a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+        for (int i = 0; i < 80; i++)
+        {
+            quint32 f, k;
+            if (i < 20)
+            {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            }
+            else if (i < 40)
+            {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            }
+            else if (i < 60)
+            {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            }
+            else
+            {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+
+            quint32 t = rotateLeft(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rotateLeft(b, 30);
+            b = a;
+            a = t;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+    }
+}
+
+#ifdef SS_CRYPTO_X86
+// AES-NI, the round keys come from the portable key expansion
+
+SS_TARGET("aes,sse4.1")
+void aesCbcEncryptAesNi(const quint8 roundKeys[RoundKeysSize], quint8 iv[16], const quint8* in, quint8* out, size_t blocks)
+{
+    __m128i keys[AesRounds + 1];
+    for (int i = 0; i <= AesRounds; i++)
+        keys[i] = _mm_loadu_si128((const __m128i*)(roundKeys + i * 16));
+
+    // Every block depends on the one before it, so there is nothing to interleave
+    __m128i state = _mm_loadu_si128((const __m128i*)iv);
+    for (size_t i = 0; i < blocks; i++, in += 16, out += 16)
+    {
+        state = _mm_xor_si128(state, _mm_loadu_si128((const __m128i*)in));
+        state = _mm_xor_si128(state, keys[0]);
+        for (int round = 1; round < AesRounds; round++)
+            state = _mm_aesenc_si128(state, keys[round]);
+        state = _mm_aesenclast_si128(state, keys[AesRounds]);
+        _mm_storeu_si128((__m128i*)out, state);
+    }
+    _mm_storeu_si128((__m128i*)iv, state);
+}
+
+SS_TARGET("aes,sse4.1")
+void aesCbcDecryptAesNi(const quint8 roundKeys[RoundKeysSize], quint8 iv[16], const quint8* in, quint8* out, size_t blocks)
+{
+    // The equivalent inverse cipher wants InvMixColumns applied to the middle round keys
+    __m128i keys[AesRounds + 1];
+    keys[0] = _mm_loadu_si128((const __m128i*)(roundKeys + AesRounds * 16));
+    for (int i = 1; i < AesRounds; i++)
+        keys[i] = _mm_aesimc_si128(_mm_loadu_si128((const __m128i*)(roundKeys + (AesRounds - i) * 16)));
+    keys[AesRounds] = _mm_loadu_si128((const __m128i*)roundKeys);
+
+    // Blocks decrypt independently, four at a time keeps the AES unit busy
+    __m128i previous = _mm_loadu_si128((const __m128i*)iv);
+    for (; blocks >= 4; blocks -= 4, in += 64, out += 64)
+    {
+        __m128i c0 = _mm_loadu_si128((const __m128i*)in);
+        __m128i c1 = _mm_loadu_si128((const __m128i*)(in + 16));
+        __m128i c2 = _mm_loadu_si128((const __m128i*)(in + 32));
+        __m128i c3 = _mm_loadu_si128((const __m128i*)(in + 48));
+        __m128i s0 = _mm_xor_si128(c0, keys[0]);
+        __m128i s1 = _mm_xor_si128(c1, keys[0]);
+        __m128i s2 = _mm_xor_si128(c2, keys[0]);
+        __m128i s3 = _mm_xor_si128(c3, keys[0]);
+        for (int round = 1; round < AesRounds; round++)
+        {
+            s0 = _mm_aesdec_si128(s0, keys[round]);
+            s1 = _mm_aesdec_si128(s1, keys[round]);
+            s2 = _mm_aesdec_si128(s2, keys[round]);
+            s3 = _mm_aesdec_si128(s3, keys[round]);
+        }
+        s0 = _mm_aesdeclast_si128(s0, keys[AesRounds]);
+        s1 = _mm_aesdeclast_si128(s1, keys[AesRounds]);
+        s2 = _mm_aesdeclast_si128(s2, keys[AesRounds]);
+        s3 = _mm_aesdeclast_si128(s3, keys[AesRounds]);
+        _mm_storeu_si128((__m128i*)out, _mm_xor_si128(s0, previous));
+        _mm_storeu_si128((__m128i*)(out + 16), _mm_xor_si128(s1, c0));
+        _mm_storeu_si128((__m128i*)(out + 32), _mm_xor_si128(s2, c1));
+        _mm_storeu_si128((__m128i*)(out + 48), _mm_xor_si128(s3, c2));
+        previous = c3;
+    }
+
+    for (; blocks; blocks--, in += 16, out += 16)
+    {
+        __m128i cipher = _mm_loadu_si128((const __m128i*)in);
+        __m128i state = _mm_xor_si128(cipher, keys[0]);
+        for (int round = 1; round < AesRounds; round++)
+            state = _mm_aesdec_si128(state, keys[round]);
+        state = _mm_aesdeclast_si128(state, keys[AesRounds]);
+        _mm_storeu_si128((__m128i*)out, _mm_xor_si128(state, previous));
+        previous = cipher;
+    }
+    _mm_storeu_si128((__m128i*)iv, previous);
+}
+
+// SHA extensions. Every group of four rounds feeds E from the previous group
+// and extends the message schedule for the groups after it.
+#define SHA1_ROUNDS4(i, function) \
+    if ((i) == 0) \
+        e[0] = _mm_add_epi32(e[0], message[0]); \
+    else \
+        e[(i) % 2] = _mm_sha1nexte_epu32(e[(i) % 2], message[(i) % 4]); \
+    e[((i) + 1) % 2] = abcd; \
+    if ((i) >= 3 && (i) <= 18) \
+        message[((i) + 1) % 4] = _mm_sha1msg2_epu32(message[((i) + 1) % 4], message[(i) % 4]); \
+    abcd = _mm_sha1rnds4_epu32(abcd, e[(i) % 2], function); \
+    if ((i) >= 1 && (i) <= 16) \
+        message[((i) + 3) % 4] = _mm_sha1msg1_epu32(message[((i) + 3) % 4], message[(i) % 4]); \
+    if ((i) >= 2 && (i) <= 17) \
+        message[((i) + 2) % 4] = _mm_xor_si128(message[((i) + 2) % 4], message[(i) % 4]);
+
+SS_TARGET("sha,sse4.1,ssse3")
+void sha1ShaNi(quint32 state[5], const quint8* data, size_t blocks)
+{
+    const __m128i byteSwap = _mm_set_epi64x(0x0001020304050607LL, 0x08090a0b0c0d0e0fLL);
+    __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)state), 0x1B);
+    __m128i e0 = _mm_set_epi32((int)state[4], 0, 0, 0);
+
+    for (; blocks; blocks--, data += 64)
+    {
+        const __m128i abcdSaved = abcd;
+        const __m128i eSaved = e0;
+        __m128i message[4];
+        for (int i = 0; i < 4; i++)
+            message[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + i * 16)), byteSwap);
+
+        __m128i e[2] = {e0, e0};
+        SHA1_ROUNDS4(0, 0)  SHA1_ROUNDS4(1, 0)  SHA1_ROUNDS4(2, 0)  SHA1_ROUNDS4(3, 0)  SHA1_ROUNDS4(4, 0)
+        SHA1_ROUNDS4(5, 1)  SHA1_ROUNDS4(6, 1)  SHA1_ROUNDS4(7, 1)  SHA1_ROUNDS4(8, 1)  SHA1_ROUNDS4(9, 1)
+        SHA1_ROUNDS4(10, 2) SHA1_ROUNDS4(11, 2) SHA1_ROUNDS4(12, 2) SHA1_ROUNDS4(13, 2) SHA1_ROUNDS4(14, 2)
+        SHA1_ROUNDS4(15, 3) SHA1_ROUNDS4(16, 3) SHA1_ROUNDS4(17, 3) SHA1_ROUNDS4(18, 3) SHA1_ROUNDS4(19, 3)
+
+        e0 = _mm_sha1nexte_epu32(e[0], eSaved);
+        abcd = _mm_add_epi32(abcd, abcdSaved);
+    }
+
+    _mm_storeu_si128((__m128i*)state, _mm_shuffle_epi32(abcd, 0x1B));
+    state[4] = (quint32)_mm_extract_epi32(e0, 3);
+}
+
+#undef SHA1_ROUNDS4
+
+void cpuid(int leaf, quint32 registers[4])
+{
+    registers[0] = registers[1] = registers[2] = registers[3] = 0;
+#ifdef Q_CC_MSVC
+    int values[4];
+    __cpuid(values, 0);
+    if (values[0] < leaf)
+        return;
+    __cpuidex(values, leaf, 0);
+    for (int i = 0; i < 4; i++)
+        registers[i] = (quint32)values[i];
+#else
+    if ((int)__get_cpuid_max(0, 0) < leaf)
+        return;
+    __cpuid_count(leaf, 0, registers[0], registers[1], registers[2], registers[3]);
+#endif
+}
+#endif // SS_CRYPTO_X86
+
+void finishSha1(Sha1Kernel kernel, quint32 state[5], quint64 length, quint8 buffer[64], size_t buffered, quint8 digest[WiiCrypto::Sha1Size])
+{
+    buffer[buffered++] = 0x80;
+    if (buffered > 56)
+    {
+        memset(buffer + buffered, 0, 64 - buffered);
+        kernel(state, buffer, 1);
+        buffered = 0;
+    }
+    memset(buffer + buffered, 0, 56 - buffered);
+
+    const quint64 bits = length * 8;
+    for (int i = 0; i < 8; i++)
+        buffer[56 + i] = (quint8)(bits >> (56 - 8 * i));
+    kernel(state, buffer, 1);
+
+    for (int i = 0; i < 5; i++)
+    {
+        digest[4 * i]     = (quint8)(state[i] >> 24);
+        digest[4 * i + 1] = (quint8)(state[i] >> 16);
+        digest[4 * i + 2] = (quint8)(state[i] >> 8);
+        digest[4 * i + 3] = (quint8)state[i];
+    }
+}
+
+const quint32 Sha1Initial[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+
+void sha1With(Sha1Kernel kernel, const quint8* data, size_t size, quint8 digest[WiiCrypto::Sha1Size])
+{
+    quint32 state[5];
+    memcpy(state, Sha1Initial, sizeof(state));
+    kernel(state, data, size / 64);
+
+    quint8 buffer[64];
+    memcpy(buffer, data + size - size % 64, size % 64);
+    finishSha1(kernel, state, size, buffer, size % 64, digest);
+}
+
+QByteArray hex(const quint8* data, int size)
+{
+    return QByteArray((const char*)data, size).toHex();
+}
+
+// FIPS-197 C.1, SP 800-38A F.2.1 and FIPS 180 / RFC 3174
+bool checkAes(AesCbcKernel encrypt, AesCbcKernel decrypt, QString* error)
+{
+    struct Vector
+    {
+        const char* key;
+        const char* iv;
+        const char* plain;
+        const char* cipher;
+    };
+    static const Vector vectors[] =
+    {
+        {"000102030405060708090a0b0c0d0e0f", "00000000000000000000000000000000",
+         "00112233445566778899aabbccddeeff", "69c4e0d86a7b0430d8cdb78070b4c55a"},
+        {"2b7e151628aed2a6abf7158809cf4f3c", "000102030405060708090a0b0c0d0e0f",
+         "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51"
+         "30c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710",
+         "7649abac8119b246cee98e9b12e9197d5086cb9b507219ee95db113a917678b2"
+         "73bed6b8e3c1743b7116e69e222295163ff1caa1681fac09120eca307586e1a7"}
+    };
+
+    for (size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++)
+    {
+        const QByteArray key = QByteArray::fromHex(vectors[i].key);
+        const QByteArray plain = QByteArray::fromHex(vectors[i].plain);
+        const QByteArray cipher = QByteArray::fromHex(vectors[i].cipher);
+        quint8 roundKeys[RoundKeysSize];
+        expandKey((const quint8*)key.constData(), roundKeys);
+
+        QByteArray iv = QByteArray::fromHex(vectors[i].iv);
+        QByteArray output(plain.size(), 0);
+        encrypt(roundKeys, (quint8*)iv.data(), (const quint8*)plain.constData(), (quint8*)output.data(), plain.size() / 16);
+        if (output != cipher)
+        {
+            if (error)
+                *error = QString("AES-CBC encryption of vector %1 gave %2").arg(i).arg(QString(output.toHex()));
+            return false;
+        }
+
+        iv = QByteArray::fromHex(vectors[i].iv);
+        decrypt(roundKeys, (quint8*)iv.data(), (const quint8*)cipher.constData(), (quint8*)output.data(), cipher.size() / 16);
+        if (output != plain)
+        {
+            if (error)
+                *error = QString("AES-CBC decryption of vector %1 gave %2").arg(i).arg(QString(output.toHex()));
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool checkSha1(Sha1Kernel kernel, QString* error)
+{
+    struct Vector
+    {
+        QByteArray message;
+        const char* digest;
+    };
+    const Vector vectors[] =
+    {
+        {QByteArray(), "da39a3ee5e6b4b0d3255bfef95601890afd80709"},
+        {QByteArray("abc"), "a9993e364706816aba3e25717850c26c9cd0d89d"},
+        {QByteArray("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"), "84983e441c3bd26ebaae4aa1f95129e5e54670f1"},
+        {QByteArray(1000000, 'a'), "34aa973cd4c4daa4f61eeb2bdbad27316534016f"}
+    };
+
+    for (size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++)
+    {
+        quint8 digest[WiiCrypto::Sha1Size];
+        sha1With(kernel, (const quint8*)vectors[i].message.constData(), vectors[i].message.size(), digest);
+        if (hex(digest, sizeof(digest)) != vectors[i].digest)
+        {
+            if (error)
+                *error = QString("SHA-1 of vector %1 gave %2").arg(i).arg(QString(hex(digest, sizeof(digest))));
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Vectors only cover a few blocks, so also compare against the portable
+// kernels over buffers that exercise the interleaved paths and their tails
+bool crossCheck(AesCbcKernel encrypt, AesCbcKernel decrypt, Sha1Kernel sha1, QString* error)
+{
+    QByteArray data(4096 + 7 * 16, 0);
+    quint32 seed = 0x2545F491;
+    for (int i = 0; i < data.size(); i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        data[i] = (char)(seed >> 24);
+    }
+    const quint8* input = (const quint8*)data.constData();
+
+    if (encrypt && decrypt)
+    {
+        quint8 roundKeys[RoundKeysSize];
+        expandKey(input, roundKeys);
+
+        // Odd block counts leave a tail after the groups of four
+        for (size_t blocks = 1; blocks * 16 <= (size_t)data.size(); blocks = blocks * 2 + 1)
+        {
+            QByteArray expected(blocks * 16, 0);
+            QByteArray output(blocks * 16, 0);
+            quint8 expectedIv[16];
+            quint8 iv[16];
+            memcpy(expectedIv, input + 16, 16);
+            memcpy(iv, input + 16, 16);
+            aesCbcEncryptPortable(roundKeys, expectedIv, input, (quint8*)expected.data(), blocks);
+            encrypt(roundKeys, iv, input, (quint8*)output.data(), blocks);
+            if (output != expected || memcmp(iv, expectedIv, 16))
+            {
+                if (error)
+                    *error = QString("AES-CBC encryption of %1 blocks differs from the portable kernel").arg(blocks);
+                return false;
+            }
+
+            memcpy(expectedIv, input + 16, 16);
+            memcpy(iv, input + 16, 16);
+            aesCbcDecryptPortable(roundKeys, expectedIv, input, (quint8*)expected.data(), blocks);
+            // In place, like the save code does
+            memcpy(output.data(), input, blocks * 16);
+            decrypt(roundKeys, iv, (const quint8*)output.constData(), (quint8*)output.data(), blocks);
+            if (output != expected || memcmp(iv, expectedIv, 16))
+            {
+                if (error)
+                    *error = QString("AES-CBC decryption of %1 blocks differs from the portable kernel").arg(blocks);
+                return false;
+            }
+        }
+    }
+
+    if (sha1)
+    {
+        for (int size = 0; size <= data.size(); size += 61)
+        {
+            quint8 expected[WiiCrypto::Sha1Size];
+            quint8 digest[WiiCrypto::Sha1Size];
+            sha1With(sha1Portable, input, size, expected);
+            sha1With(sha1, input, size, digest);
+            if (memcmp(digest, expected, sizeof(digest)))
+            {
+                if (error)
+                    *error = QString("SHA-1 of %1 bytes differs from the portable kernel").arg(size);
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Picked once, an accelerated kernel is only used if the CPU has the
+// instructions and it reproduces the vectors
+struct Kernels
+{
+    Kernels()
+        : aesEncrypt(NULL),
+          aesDecrypt(NULL),
+          sha1(NULL)
+    {
+#ifdef SS_CRYPTO_X86
+        quint32 features[4];
+        cpuid(1, features);
+        const bool sse41 = features[2] & (1 << 19);
+        const bool ssse3 = features[2] & (1 << 9);
+        const bool aes   = features[2] & (1 << 25);
+        cpuid(7, features);
+        const bool sha   = features[1] & (1 << 29);
+
+        if (aes && sse41)
+        {
+            aesEncrypt = aesCbcEncryptAesNi;
+            aesDecrypt = aesCbcDecryptAesNi;
+        }
+        if (sha && sse41 && ssse3)
+            sha1 = sha1ShaNi;
+
+        QString error;
+        if (aesEncrypt && (!checkAes(aesEncrypt, aesDecrypt, &error) || !crossCheck(aesEncrypt, aesDecrypt, NULL, &error)))
+        {
+            qWarning("AES-NI disabled: %s", qPrintable(error));
+            aesEncrypt = aesDecrypt = NULL;
+        }
+        if (sha1 && (!checkSha1(sha1, &error) || !crossCheck(NULL, NULL, sha1, &error)))
+        {
+            qWarning("SHA extensions disabled: %s", qPrintable(error));
+            sha1 = NULL;
+        }
+#endif
+    }
+
+    AesCbcKernel aesEncrypt;
+    AesCbcKernel aesDecrypt;
+    Sha1Kernel   sha1;
+};
+
+const Kernels& availableKernels()
+{
+    static const Kernels kernels;
+    return kernels;
+}
+
+QAtomicInt accelerationEnabled(1);
+
+AesCbcKernel aesEncryptKernel()
+{
+    const Kernels& available = availableKernels();
+    return available.aesEncrypt && accelerationEnabled.load() ? available.aesEncrypt : aesCbcEncryptPortable;
+}
+
+AesCbcKernel aesDecryptKernel()
+{
+    const Kernels& available = availableKernels();
+    return available.aesDecrypt && accelerationEnabled.load() ? available.aesDecrypt : aesCbcDecryptPortable;
+}
+
+Sha1Kernel sha1Kernel()
+{
+    const Kernels& available = availableKernels();
+    return available.sha1 && accelerationEnabled.load() ? available.sha1 : sha1Portable;
+}
+}
+
+void WiiCrypto::aesCbcEncrypt(const quint8 key[AesKeySize], quint8 iv[AesBlockSize], const quint8* in, quint8* out, size_t size)
+{
+    Q_ASSERT(size % AesBlockSize == 0);
+    quint8 roundKeys[RoundKeysSize];
+    expandKey(key, roundKeys);
+    aesEncryptKernel()(roundKeys, iv, in, out, size / AesBlockSize);
+}
+
+void WiiCrypto::aesCbcDecrypt(const quint8 key[AesKeySize], quint8 iv[AesBlockSize], const quint8* in, quint8* out, size_t size)
+{
+    Q_ASSERT(size % AesBlockSize == 0);
+    quint8 roundKeys[RoundKeysSize];
+    expandKey(key, roundKeys);
+    aesDecryptKernel()(roundKeys, iv, in, out, size / AesBlockSize);
+}
+
+void WiiCrypto::sha1(const void* data, size_t size, quint8 digest[Sha1Size])
+{
+    sha1With(sha1Kernel(), (const quint8*)data, size, digest);
+}
+
+bool WiiCrypto::isAesAccelerated()
+{
+    return availableKernels().aesEncrypt && accelerationEnabled.load();
+}
+
+bool WiiCrypto::isShaAccelerated()
+{
+    return availableKernels().sha1 && accelerationEnabled.load();
+}
+
+void WiiCrypto::setAccelerationEnabled(bool enabled)
+{
+    accelerationEnabled.store(enabled ? 1 : 0);
+}
+
+QString WiiCrypto::kernels()
+{
+    return QString("AES %1, SHA-1 %2").arg(isAesAccelerated() ? "AES-NI" : "portable")
+                                     .arg(isShaAccelerated() ? "SHA extensions" : "portable");
+}
+
+bool WiiCrypto::selfTest(QString* error)
+{
+    if (!checkAes(aesCbcEncryptPortable, aesCbcDecryptPortable, error) || !checkSha1(sha1Portable, error))
+        return false;
+
+    const Kernels& available = availableKernels();
+    if (available.aesEncrypt && (!checkAes(available.aesEncrypt, available.aesDecrypt, error) ||
+                                 !crossCheck(available.aesEncrypt, available.aesDecrypt, NULL, error)))
+        return false;
+    if (available.sha1 && (!checkSha1(available.sha1, error) || !crossCheck(NULL, NULL, available.sha1, error)))
+        return false;
+
+    return true;
+}
@@ -0,0 +1,58 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+
+#ifndef WIICRYPTO_HPP
+#define WIICRYPTO_HPP
+
+#include <QtGlobal>
+#include <QString>
+#include <stddef.h>
+
+// AES-128-CBC and SHA-1 as WiiSaves use them. Uses AES-NI and the SHA extensions
+// when the CPU has them and they reproduce the FIPS test vectors, the
+// portable kernels otherwise. Safe to use from any thread.
+// WiiSaves are packed by the plugins' exportWiiSave in PluginFramework, which
+// doesn't call these yet, so only the benchmarks and sakurasuite_crypto_test
+// build them.
+class WiiCrypto
+{
+public:
+    enum
+    {
+        AesKeySize   = 16,
+        AesBlockSize = 16,
+        Sha1Size     = 20
+    };
+
+    // size must be a multiple of AesBlockSize, in and out may be the same buffer.
+    // iv is updated, so a long buffer can be processed in pieces.
+    static void aesCbcEncrypt(const quint8 key[AesKeySize], quint8 iv[AesBlockSize], const quint8* in, quint8* out, size_t size);
+    static void aesCbcDecrypt(const quint8 key[AesKeySize], quint8 iv[AesBlockSize], const quint8* in, quint8* out, size_t size);
+    static void sha1(const void* data, size_t size, quint8 digest[Sha1Size]);
+
+    static bool isAesAccelerated();
+    static bool isShaAccelerated();
+    // Off forces the portable kernels, to compare them
+    static void setAccelerationEnabled(bool enabled);
+    // e.g. "AES AES-NI, SHA-1 portable"
+    static QString kernels();
+
+    // Checks every kernel this CPU can run against the FIPS test vectors
+    // and against each other
+    static bool selfTest(QString* error = 0);
+};
+
+#endif // WIICRYPTO_HPP
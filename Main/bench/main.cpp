@@ -0,0 +1,331 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+
+// sakurasuite_bench, micro benchmarks of the editor core.
+// Runs on the offscreen platform with settings, logs and plugins of its own,
+// so it never touches the user's editor. Results are written as JSON, see
+// BenchmarkRunner for the options.
+
+#include "BenchmarkRunner.hpp"
+#include "SyntheticPlugin.hpp"
+#include "ApplicationLog.hpp"
+#include "MainWindow.hpp"
+#include "OutputStreamMonitor.hpp"
+#include "PluginsManager.hpp"
+#include "WiiCrypto.hpp"
+#include "WiiKeyManager.hpp"
+#include <QApplication>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QVector>
+#include <stdio.h>
+
+namespace
+{
+// Discards everything written to it
+class NullBuffer : public std::streambuf
+{
+protected:
+    int_type overflow(int_type c)
+    {
+        return traits_type::not_eof(c);
+    }
+
+    std::streamsize xsputn(const char*, std::streamsize n)
+    {
+        return n;
+    }
+};
+
+class LineCounter : public QObject
+{
+    Q_OBJECT
+public:
+    LineCounter() : lines(0) {}
+    qint64 lines;
+public slots:
+    void onMessages(QStringList messages)
+    {
+        lines += messages.count();
+    }
+};
+
+QList<SyntheticPlugin*> createPlugins(PluginsManager* manager, int count)
+{
+    QList<SyntheticPlugin*> plugins;
+    for (int i = 0; i < count; i++)
+    {
+        SyntheticPlugin::Config config;
+        config.name = QString("Synthetic%1").arg(i);
+        config.extension = QString("syn%1").arg(i);
+        SyntheticPlugin* plugin = new SyntheticPlugin(config);
+        manager->registerPlugin(plugin);
+        plugins << plugin;
+    }
+
+    return plugins;
+}
+
+void destroyPlugins(MainWindow* window, const QList<SyntheticPlugin*>& plugins)
+{
+    foreach (SyntheticPlugin* plugin, plugins)
+    {
+        window->removeFileFilter(plugin->filter());
+        delete plugin;
+    }
+}
+
+void benchmarkPlugins(BenchmarkRunner& runner, MainWindow* window)
+{
+    const int counts[] = {1, 10, 100, 1000};
+    for (unsigned i = 0; i < sizeof(counts) / sizeof(counts[0]); i++)
+    {
+        const int count = counts[i];
+        if (!runner.isSelected("PluginsManager::preferredPlugin") && !runner.isSelected("PluginsManager::plugin"))
+            continue;
+
+        PluginsManager manager(window);
+        QList<SyntheticPlugin*> plugins = createPlugins(&manager, count);
+        QVariantMap parameters;
+        parameters["plugins"] = count;
+
+        // Only the last plugin accepts the file, so every plugin is probed
+        const QString file = QString("/data/level.syn%1").arg(count - 1);
+        runner.run("PluginsManager::preferredPlugin", parameters, [&](qint64 iterations)
+        {
+            for (qint64 j = 0; j < iterations; j++)
+                BenchmarkRunner::keep(manager.preferredPlugin(file));
+        });
+
+        const QString name = QString("SYNTHETIC%1").arg(count - 1);
+        runner.run("PluginsManager::plugin", parameters, [&](qint64 iterations)
+        {
+            for (qint64 j = 0; j < iterations; j++)
+                BenchmarkRunner::keep(manager.plugin(name));
+        });
+
+        destroyPlugins(window, plugins);
+    }
+}
+
+void benchmarkLog(BenchmarkRunner& runner)
+{
+    ApplicationLog* log = ApplicationLog::instance();
+    QVector<QString> messages;
+    for (int i = 0; i < 1024; i++)
+        messages << QString("Loaded actor %1 from stage %2").arg(i).arg(i % 7);
+
+    QMessageLogContext context("BenchmarkLog.cpp", 42, "void benchmarkLog()", "default");
+    const ApplicationLog::Level levels[] = {ApplicationLog::Debug, ApplicationLog::Error};
+    const char* names[] = {"debug", "error"};
+    for (int i = 0; i < 2; i++)
+    {
+        // Debug messages from one location are rate limited, errors take the full path
+        const ApplicationLog::Level level = levels[i];
+        QVariantMap parameters;
+        parameters["level"] = QString(names[i]);
+        runner.run("ApplicationLog::addMessage", parameters, [&](qint64 iterations)
+        {
+            for (qint64 j = 0; j < iterations; j++)
+                log->addMessage(level, context, messages.at(j & 1023));
+            log->drain();
+        });
+    }
+}
+
+void benchmarkOutputStream(BenchmarkRunner& runner)
+{
+    NullBuffer nullBuffer;
+    std::ostream stream(&nullBuffer);
+    OutputStreamMonitor monitor(stream);
+    LineCounter counter;
+    QObject::connect(&monitor, SIGNAL(messagesRecieved(QStringList)), &counter, SLOT(onMessages(QStringList)), Qt::DirectConnection);
+
+    const int lengths[] = {16, 80, 1024};
+    for (unsigned i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++)
+    {
+        const std::string line = std::string(lengths[i] - 1, 'x') + "\n";
+        QVariantMap parameters;
+        parameters["bytes"] = lengths[i];
+        runner.run("OutputStreamMonitor::write", parameters, [&](qint64 iterations)
+        {
+            for (qint64 j = 0; j < iterations; j++)
+                stream << line;
+            stream.flush();
+        });
+    }
+}
+
+void benchmarkMainWindow(BenchmarkRunner& runner, MainWindow* window)
+{
+    const QString path("C:\\Users\\artist\\Documents\\SakuraSuite\\stages\\Forest\\room_01.arc");
+    runner.run("MainWindow::cleanPath", QVariantMap(), [&](qint64 iterations)
+    {
+        for (qint64 i = 0; i < iterations; i++)
+            BenchmarkRunner::keep(window->cleanPath(path));
+    });
+
+    QStringList files;
+    for (int i = 0; i < MainWindow::MAXRECENT * 2; i++)
+        files << QString("/data/stages/room_%1.arc").arg(i);
+    // updateMRU is a slot, going through the meta object is the only way in
+    runner.run("MainWindow::updateMRU", QVariantMap(), [&](qint64 iterations)
+    {
+        for (qint64 i = 0; i < iterations; i++)
+            QMetaObject::invokeMethod(window, "updateMRU", Qt::DirectConnection, Q_ARG(QString, files.at(i % files.count())));
+    });
+
+    SyntheticPlugin plugin;
+    const int counts[] = {0, 100, 1000};
+    for (unsigned i = 0; i < sizeof(counts) / sizeof(counts[0]); i++)
+    {
+        for (int j = 0; j < counts[i]; j++)
+            window->onNewDocument(plugin.loadFile(QString("/data/document%1.syn").arg(j)));
+
+        QVariantMap parameters;
+        parameters["documents"] = counts[i];
+        runner.run("MainWindow::addRemoveDocument", parameters, [&](qint64 iterations)
+        {
+            for (qint64 j = 0; j < iterations; j++)
+            {
+                window->onNewDocument(plugin.loadFile("/data/extra.syn"));
+                QMetaObject::invokeMethod(window, "onClose", Qt::DirectConnection);
+            }
+        });
+
+        QMetaObject::invokeMethod(window, "onCloseAll", Qt::DirectConnection);
+    }
+}
+
+void benchmarkKeys(BenchmarkRunner& runner, MainWindow* window, const QString& directory)
+{
+    // A BackupMii dump with made up keys
+    QByteArray dump(0x400, '\0');
+    dump.replace(0, 12, "BackupMii v1");
+    for (int i = 0x124; i < 0x248; i++)
+        dump[i] = (char)i;
+
+    const QString path = directory + "/keys.bin";
+    QFile file(path);
+    if (!file.open(QFile::WriteOnly) || file.write(dump) != dump.size())
+    {
+        fprintf(stderr, "Unable to write %s\n", qPrintable(path));
+        return;
+    }
+    file.close();
+
+    WiiKeyManager keyManager(window);
+    runner.run("WiiKeyManager::open", QVariantMap(), [&](qint64 iterations)
+    {
+        for (qint64 i = 0; i < iterations; i++)
+            BenchmarkRunner::keep(keyManager.open(path, true));
+    });
+
+    runner.run("WiiKeyManager::selectConsole", QVariantMap(), [&](qint64 iterations)
+    {
+        for (qint64 i = 0; i < iterations; i++)
+            BenchmarkRunner::keep(keyManager.selectConsole(keyManager.ngId()));
+    });
+}
+
+void benchmarkCrypto(BenchmarkRunner& runner)
+{
+    // About the size of a large data.bin
+    QByteArray data(1 << 20, '\0');
+    for (int i = 0; i < data.size(); i++)
+        data[i] = (char)(i * 7);
+    QByteArray output(data.size(), '\0');
+    const quint8 key[WiiCrypto::AesKeySize] = {0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+
+    // The portable kernels always run, the accelerated ones where the CPU has them
+    for (int accelerated = 0; accelerated < 2; accelerated++)
+    {
+        WiiCrypto::setAccelerationEnabled(accelerated);
+        if (accelerated && !WiiCrypto::isAesAccelerated() && !WiiCrypto::isShaAccelerated())
+            break;
+
+        QVariantMap parameters;
+        parameters["bytes"] = data.size();
+        parameters["kernels"] = WiiCrypto::kernels();
+
+        runner.run("WiiCrypto::aesCbcEncrypt", parameters, [&](qint64 iterations)
+        {
+            for (qint64 i = 0; i < iterations; i++)
+            {
+                quint8 iv[WiiCrypto::AesBlockSize] = {0};
+                WiiCrypto::aesCbcEncrypt(key, iv, (const quint8*)data.constData(), (quint8*)output.data(), data.size());
+                BenchmarkRunner::keep(output.constData());
+            }
+        });
+
+        runner.run("WiiCrypto::aesCbcDecrypt", parameters, [&](qint64 iterations)
+        {
+            for (qint64 i = 0; i < iterations; i++)
+            {
+                quint8 iv[WiiCrypto::AesBlockSize] = {0};
+                WiiCrypto::aesCbcDecrypt(key, iv, (const quint8*)data.constData(), (quint8*)output.data(), data.size());
+                BenchmarkRunner::keep(output.constData());
+            }
+        });
+
+        runner.run("WiiCrypto::sha1", parameters, [&](qint64 iterations)
+        {
+            for (qint64 i = 0; i < iterations; i++)
+            {
+                quint8 digest[WiiCrypto::Sha1Size];
+                WiiCrypto::sha1(data.constData(), data.size(), digest);
+                BenchmarkRunner::keep(digest[0]);
+            }
+        });
+    }
+    WiiCrypto::setAccelerationEnabled(true);
+}
+}
+
+int main(int argc, char* argv[])
+{
+    // Everything is set up before the first use of the settings, the log or the plugins
+    QTemporaryDir sandbox;
+    if (!BenchmarkRunner::setUpSandbox(sandbox, "sakurasuite_bench"))
+        return 1;
+
+    QDir(sandbox.path()).mkpath("plugins");
+    if (qgetenv("SAKURASUITE_PLUGIN_PATH").isEmpty())
+        qputenv("SAKURASUITE_PLUGIN_PATH", QFile::encodeName(sandbox.path() + "/plugins"));
+
+    QApplication app(argc, argv);
+
+    BenchmarkRunner runner;
+    if (!runner.parseArguments(app.arguments()))
+        return 1;
+
+    ApplicationLog::instance();
+    BenchmarkRunner::installMessageHandler();
+
+    MainWindow* window = new MainWindow;
+    benchmarkPlugins(runner, window);
+    benchmarkLog(runner);
+    benchmarkOutputStream(runner);
+    benchmarkMainWindow(runner, window);
+    benchmarkKeys(runner, window, sandbox.path());
+    benchmarkCrypto(runner);
+    delete window;
+
+    return runner.write("sakurasuite_bench") ? 0 : 1;
+}
+
+#include "main.moc"
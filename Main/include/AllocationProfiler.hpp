@@ -0,0 +1,81 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+
+#ifndef ALLOCATIONPROFILER_HPP
+#define ALLOCATIONPROFILER_HPP
+
+#include <QList>
+#include <QString>
+
+// Counts the heap allocations made while a Scope is active on the thread, by the
+// scope's tag, allocations outside any scope are "untagged". Only compiled in with
+// SS_ALLOC_PROFILING, the CMake option of that name or CONFIG+=alloc_profiling,
+// on Linux with glibc only, otherwise scopes compile to nothing and nothing is counted.
+class AllocationProfiler
+{
+public:
+    enum { MaxTags = 128 };
+
+    struct Usage
+    {
+        Usage();
+        QString tag;
+        qint64  allocations;
+        qint64  bytes;
+        // Bytes still allocated, and the most there ever were
+        qint64  live;
+        qint64  peak;
+    };
+
+    class Scope
+    {
+    public:
+        // Tags are looked up by address first, so literals are cheapest.
+        // An empty tag keeps the enclosing scope's.
+        explicit Scope(const char* tag);
+        explicit Scope(const QString& tag);
+        ~Scope();
+
+    private:
+        Q_DISABLE_COPY(Scope)
+        int m_previous;
+    };
+
+    static bool isEnabled();
+    // Most bytes allocated first
+    static QList<Usage> usage();
+    // Starts counting allocations over, what is live stays live
+    static void reset();
+    static QString report();
+};
+
+#ifndef SS_ALLOC_PROFILING
+inline AllocationProfiler::Scope::Scope(const char*)
+    : m_previous(0)
+{
+}
+
+inline AllocationProfiler::Scope::Scope(const QString&)
+    : m_previous(0)
+{
+}
+
+inline AllocationProfiler::Scope::~Scope()
+{
+}
+#endif
+
+#endif // ALLOCATIONPROFILER_HPP
@@ -3,7 +3,13 @@
 
 #include <QDialog>
 #include <QDateTime>
+#include <QFile>
+#include <QTimer>
 #include "OutputStreamMonitor.hpp"
+#include "LogBuffer.hpp"
+#include "LogIndex.hpp"
+#include "LogQueue.hpp"
+#include "LogWriter.hpp"
 
 namespace Ui {
 class ApplicationLog;
@@ -13,44 +19,89 @@ QT_BEGIN_NAMESPACE
 class QAbstractButton;
 QT_END_NAMESPACE
 
+class LogModel;
+
 class ApplicationLog : public QDialog
 {
     Q_OBJECT
 
 public:
+    enum Level
+    {
+        Debug,
+        Warning,
+        Error,
+        Fatal
+    };
+
     static ApplicationLog* instance();
     ~ApplicationLog();
+
+    // Safe to call from any thread, the message is queued and added to the
+    // log by the GUI thread
+    void addMessage(Level level, const QMessageLogContext& context, const QString& message);
+    static QString formatEntry(qint64 timestamp, quint8 level, const QString& location, const QString& message);
 public slots:
     void debug(const QString& debug);
     void warning(const QString& warning);
     void error(const QString& error);
     void fatal(const QString& fatal);
+    // Saves the entries the dialog currently shows
     void saveLog(const QString& logFilename);
+    // Adds all queued messages to the log, GUI thread only
+    void drain();
 private slots:
     void onButtonPressed();
-    void onStdOut(QString msg);
-    void onStdLog(QString msg);
-    void onStdErr(QString msg);
+    void onStdOut(QStringList lines);
+    void onStdLog(QStringList lines);
+    void onStdErr(QStringList lines);
+    void onRowsInserted(const QModelIndex& parent, int first, int last);
+    void onSettingChanged(const QString& key, const QVariant& value);
+    void onFilterChanged();
+    void applyFilter();
+    void updateSince();
+    void reportAllSuppressed();
+protected:
+    void showEvent(QShowEvent* event);
+    void hideEvent(QHideEvent* event);
 private:
     explicit ApplicationLog();
-    enum Level
-    {
-        Debug,
-        Warning,
-        Error,
-        Fatal
-    };
 
-    struct Entry
+    void post(Level level, const QString& message, const char* file = 0, int line = 0, const char* function = 0);
+    void addEntry(Level level, const QString& message, quint32 source, qint64 timestamp);
+    // Start of the time window picked in the dialog, 0 for none
+    qint64 since() const;
+    bool isRepeat(Level level, const QString& message, quint32 source) const;
+    void reportRepeats(QVector<LogWriter::Record>& records);
+    bool takeToken(Level level, quint32 source, qint64 timestamp, QVector<LogWriter::Record>& records);
+    void reportSuppressed(quint32 source, qint64 timestamp, QVector<LogWriter::Record>& records);
+    QString formatEntry(const LogBuffer::Entry& entry) const;
+    void spill(const LogBuffer::Entry& entry);
+    Ui::ApplicationLog *ui;
+    LogBuffer m_messages;
+    LogIndex  m_index;
+    QTimer    m_filterTimer;
+    QTimer    m_sinceTimer;
+    QTimer    m_suppressedTimer;
+    LogModel* m_model;
+    int       m_messageWidth;
+    bool      m_spillEvicted;
+    QFile     m_spillFile;
+    LogQueue  m_queue;
+    LogWriter m_writer;
+
+    // Per source token bucket, refilled at a fixed rate
+    struct Bucket
     {
-        Level level;
-        QDateTime dateTime;
-        QString message;
+        Bucket();
+        double  tokens;
+        qint64  lastRefill;
+        quint32 suppressed;
     };
-
-    void addEntry(Level level, const QString& debug);
-    Ui::ApplicationLog *ui;
-    QList<Entry> m_messages;
+    QVector<Bucket> m_buckets;
+    // Repeats of the newest entry that the log file hasn't heard about yet
+    quint32   m_unreportedRepeats;
+    QAtomicInt m_drainScheduled;
     static ApplicationLog *m_instance;
     OutputStreamMonitor    m_stdoutMonitor;
     OutputStreamMonitor    m_stdlogMonitor;
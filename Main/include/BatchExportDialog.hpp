@@ -0,0 +1,77 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+
+#ifndef BATCHEXPORTDIALOG_HPP
+#define BATCHEXPORTDIALOG_HPP
+
+#include <QDialog>
+#include <QList>
+#include <QPointer>
+#include <QTimer>
+
+namespace Ui {
+class BatchExportDialog;
+}
+
+class GameDocument;
+
+// Exports the WiiSaves of many documents and shows how each is doing. The
+// plugins' exportWiiSave isn't known to be thread safe, so the exports run one
+// at a time on the GUI thread, with the events in between handled so Cancel
+// works. The dialog is modal, so the keys and the documents can't change.
+// exportWiiSave serializes, encrypts, signs and writes data.bin in one call,
+// so none of it can move to worker threads from here, and the file is only
+// written atomically if the plugin does so.
+class BatchExportDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    enum
+    {
+        DocumentColumn,
+        PluginColumn,
+        StatusColumn,
+        TimeColumn
+    };
+
+    explicit BatchExportDialog(QWidget* parent = 0);
+    ~BatchExportDialog();
+
+    // Documents without WiiSave support are left out
+    void setDocuments(const QList<GameDocument*>& documents);
+
+public slots:
+    void reject();
+
+private slots:
+    void onExport();
+    void exportNext();
+
+private:
+    void scheduleNext();
+    void cancel();
+    void setRunning(bool running);
+
+    Ui::BatchExportDialog*        ui;
+    QList<QPointer<GameDocument> > m_documents;
+    // Indexes of the documents still to export, the first is exported next
+    QList<int>                    m_queue;
+    QTimer                        m_nextTimer;
+    int                           m_failed;
+};
+
+#endif // BATCHEXPORTDIALOG_HPP
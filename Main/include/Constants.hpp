@@ -85,10 +85,9 @@ const QString SAKURASUITE_NOT_LATEST_VERSION_MSG    = tr("An update is available
                                                       "The changelog is available at: <a href=\"%4\">%4</a>")
                                                    .arg(SAKURASUITE_TITLE);
 const QString SAKURASUITE_INSTANCE_EXISTS           = tr("Single Instance error...");
-const QString SAKURASUITE_INSTANCE_EXISTS_MSG       = tr("An instance %1 is already running<br />"
-                                                      "If this is an error you can delete the lock file at<br>"
-                                                      "%2<br/>"
-                                                      "%1 is designed to ignore locks older than 60 seconds, so you may also wait if you wish")
+const QString SAKURASUITE_INSTANCE_EXISTS_MSG       = tr("An instance of %1 is already running but did not respond.\n"
+                                                      "If this is an error you can delete the lock file at\n"
+                                                      "%2")
                                                    .arg(SAKURASUITE_TITLE)
                                                    .arg(SAKURASUITE_LOCK_FILE);
 const QString SAKURASUITE_BUILD_DATE                = tr(__DATE__ " " __TIME__);
@@ -139,6 +138,12 @@ const QString SAKURASUITE_CURRENT_STYLE          = QString("currentStyle");
 const QString SAKURASUITE_CHECK_ON_START         = QString("checkForUpdatesOnStart");
 const QString SAKURASUITE_ENGINE_DATA_PATH       = QString("engineDataPath");
 const QString SAKURASUITE_ENGINE_EXECUTABLE      = QString("engineExecutable");
+const QString SAKURASUITE_SINGLE_INSTANCE        = QString("singleInstance");
+const QString SAKURASUITE_SESSION_FILES          = QString("sessionFiles");
+const QString SAKURASUITE_LOG_CAPACITY           = QString("logCapacity");
+const QString SAKURASUITE_LOG_SPILL_EVICTED      = QString("logSpillEvicted");
+const QString SAKURASUITE_LOG_LEVELS             = QString("logLevels");
+const QString SAKURASUITE_STALL_THRESHOLD        = QString("stallThreshold");
 }
 
 #undef tr
@@ -0,0 +1,72 @@
+#ifndef LOGBUFFER_HPP
+#define LOGBUFFER_HPP
+
+#include <QByteArray>
+#include <QHash>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+// Fixed capacity ring of log entries, the oldest entry is evicted when full.
+// Source locations are interned so each entry only carries an index.
+class LogBuffer
+{
+public:
+    struct Entry
+    {
+        qint64  timestamp; // msecs since epoch, UTC
+        quint32 source;
+        quint8  level;
+        QString message;
+        // Identical consecutive messages are collapsed into one entry
+        quint32 count;
+        qint64  lastSeen;
+    };
+
+    struct Source
+    {
+        QByteArray file;
+        int        line;
+        QByteArray function;
+        QString    text;
+    };
+
+    explicit LogBuffer(int capacity);
+
+    int capacity() const;
+    int count() const;
+    bool isEmpty() const;
+
+    // 0 is the oldest entry
+    const Entry& at(int i) const;
+    const Entry& last() const;
+
+    // Every entry ever appended gets the next sequence number,
+    // at(i) has sequence firstSequence() + i
+    quint64 firstSequence() const;
+    // Returns -1 if the entry has been evicted or doesn't exist yet
+    int indexOf(quint64 sequence) const;
+    // Index of the first entry logged at or after timestamp
+    int lowerBound(qint64 timestamp) const;
+
+    // Returns true if the oldest entry had to be evicted, it's copied to evicted if given
+    bool append(const Entry& entry, Entry* evicted = 0);
+    // Counts another occurrence of the newest entry
+    void repeatLast(qint64 timestamp);
+
+    // Source 0 is reserved for messages without a location
+    quint32 intern(const char* file, int line, const char* function);
+    const Source& source(quint32 index) const;
+    // "file(line) function", formatted once when the location is interned
+    const QString& location(quint32 index) const;
+
+private:
+    QVector<Entry>  m_entries;
+    int             m_head;
+    int             m_count;
+    quint64         m_appended;
+    QVector<Source> m_sources;
+    QHash<QPair<const void*, int>, quint32> m_sourceIndex;
+};
+
+#endif // LOGBUFFER_HPP
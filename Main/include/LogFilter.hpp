@@ -0,0 +1,18 @@
+#ifndef LOGFILTER_HPP
+#define LOGFILTER_HPP
+
+#include <QString>
+
+// Runtime minimum level per logging category.
+// Rules are "category=level" pairs separated by newlines or semicolons,
+// where category may end in '*' and level is one of debug, info, warning,
+// error, fatal or off. The last matching rule wins.
+// Disabled levels are switched off on the QLoggingCategory itself, so
+// qCDebug() and friends skip building the message altogether.
+class LogFilter
+{
+public:
+    static void setRules(const QString& rules);
+};
+
+#endif // LOGFILTER_HPP
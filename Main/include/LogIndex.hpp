@@ -0,0 +1,47 @@
+#ifndef LOGINDEX_HPP
+#define LOGINDEX_HPP
+
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+#include "LogBuffer.hpp"
+
+// Secondary indexes over a LogBuffer's sequence numbers, by level and by
+// source file, used to answer log queries without walking every entry.
+// Time ranges are found with a binary search over the buffer itself.
+class LogIndex
+{
+public:
+    struct Query
+    {
+        Query();
+        bool isEmpty() const;
+
+        int     minimumLevel;
+        QString file;     // matches any source file containing it
+        QString text;     // matches any message containing it
+        qint64  since;    // msecs since epoch, 0 for no limit
+    };
+
+    LogIndex();
+
+    void append(quint64 sequence, quint8 level, const QByteArray& file);
+    // Forget everything before firstSequence
+    void prune(quint64 firstSequence);
+
+    // Sequence numbers of all entries in buffer matching query, in order
+    QVector<quint64> match(const Query& query, const LogBuffer& buffer) const;
+    bool matches(const Query& query, const LogBuffer& buffer, const LogBuffer::Entry& entry) const;
+
+    QStringList files() const;
+
+private:
+    enum { LevelCount = 4 };
+
+    QVector<quint64> m_byLevel[LevelCount];
+    QHash<QByteArray, QVector<quint64> > m_byFile;
+    quint64 m_firstSequence;
+    quint64 m_compactedAt;
+};
+
+#endif // LOGINDEX_HPP
@@ -0,0 +1,71 @@
+#ifndef LOGMODEL_HPP
+#define LOGMODEL_HPP
+
+#include <QAbstractTableModel>
+#include <QIcon>
+#include "LogBuffer.hpp"
+#include "LogIndex.hpp"
+
+// Table view over a LogBuffer, optionally limited to the entries matching
+// a query.
+// Changes to the buffer are reported with entryAppended() and published to
+// views in one batch per event loop iteration, so a burst of messages
+// results in a single insertion instead of one per message. While a query
+// is set only the new entries of each batch are checked against it.
+class LogModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    enum Column
+    {
+        MessageColumn,
+        DateTimeColumn,
+        ColumnCount
+    };
+
+    LogModel(const LogBuffer* buffer, const LogIndex* index, QObject* parent = 0);
+
+    void entryAppended();
+    void entryRepeated();
+
+    void setQuery(const LogIndex::Query& query);
+    const LogIndex::Query& query() const;
+    // Moves the start of the query's time window, moving it forward only drops rows from the top
+    void setSince(qint64 since);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
+
+    // NULL if the row's entry has been evicted since the last flush
+    const LogBuffer::Entry* entry(int row) const;
+    QString messageText(int row) const;
+    QString dateTimeText(int row) const;
+
+public slots:
+    void flush();
+
+private:
+    void scheduleFlush();
+    quint64 sequence(int row) const;
+
+    const LogBuffer* m_buffer;
+    const LogIndex*  m_index;
+    LogIndex::Query  m_query;
+    bool             m_filtered;
+    // Without a query row r is sequence m_firstSequence + r,
+    // with one it's m_matches[r]
+    quint64          m_firstSequence;
+    int              m_rows;
+    QVector<quint64> m_matches;
+    // First sequence number the view hasn't been told about
+    quint64          m_nextSequence;
+    bool  m_lastChanged;
+    bool  m_flushScheduled;
+    QIcon m_debugIcon;
+    QIcon m_warningIcon;
+    QIcon m_errorIcon;
+};
+
+#endif // LOGMODEL_HPP
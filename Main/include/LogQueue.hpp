@@ -0,0 +1,47 @@
+#ifndef LOGQUEUE_HPP
+#define LOGQUEUE_HPP
+
+#include <QAtomicPointer>
+#include <QString>
+
+// Unbounded multi producer, single consumer queue of log messages
+// (Dmitry Vyukov's intrusive MPSC queue).
+// push() is wait free and may be called from any thread, pop() must only
+// ever be called from a single consumer thread.
+class LogQueue
+{
+public:
+    struct Node
+    {
+        QAtomicPointer<Node> next;
+        qint64      timestamp;
+        quint8      level;
+        const char* file;
+        int         line;
+        const char* function;
+        QString     message;
+    };
+
+    LogQueue();
+    ~LogQueue();
+
+    // Nodes come from a per thread cache, refilled in one go with the nodes
+    // the consumer released, so logging only allocates until the pool is warm
+    static Node* allocate();
+    static void release(Node* node);
+
+    void push(Node* node);
+    // Returns NULL when the queue is empty or a producer is in the middle of a push,
+    // the caller owns the returned node
+    Node* pop();
+    bool isEmpty() const;
+
+private:
+    Q_DISABLE_COPY(LogQueue)
+
+    QAtomicPointer<Node> m_head;
+    Node*                m_tail;
+    Node                 m_stub;
+};
+
+#endif // LOGQUEUE_HPP
@@ -0,0 +1,55 @@
+#ifndef LOGWRITER_HPP
+#define LOGWRITER_HPP
+
+#include <QThread>
+#include <QFile>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVector>
+
+// Streams log records to a file on a background thread, they're only
+// formatted there.
+// Every batch is handed to the OS as soon as it's written, so the log
+// survives the application crashing. Once the file grows past MaxFileSize
+// it's renamed to <file>.1, older files move up one number and the
+// oldest is dropped. A log left behind by the previous run is rotated on start.
+class LogWriter : public QThread
+{
+    Q_OBJECT
+public:
+    struct Record
+    {
+        qint64  timestamp;
+        quint8  level;
+        QString location;
+        QString message;
+    };
+
+    explicit LogWriter(const QString& fileName, QObject* parent = 0);
+    ~LogWriter();
+
+    // Safe to call from any thread
+    void write(const QVector<Record>& records);
+    // Blocks until everything written so far is in the file
+    void flush();
+    void stop();
+
+protected:
+    void run();
+
+private:
+    bool open();
+    void rotate();
+
+    QString        m_fileName;
+    QFile          m_file;
+    QMutex         m_mutex;
+    QWaitCondition m_pending;
+    QWaitCondition m_written;
+    QVector<Record> m_records;
+    qint64         m_dropped;
+    bool           m_writing;
+    bool           m_stop;
+};
+
+#endif // LOGWRITER_HPP
@@ -36,6 +36,12 @@ class AboutDialog;
 class PreferencesDialog;
 class WiiKeyManager;
 class ApplicationLog;
+class SearchDock;
+class SettingsStore;
+class PageCacheWarmer;
+class PerformanceDialog;
+class BatchExportDialog;
+class TraceInterface;
 
 namespace Ui {
 class MainWindow;
@@ -52,7 +58,8 @@ public:
     {
         FILENAME = Qt::UserRole + 1,
         FILEPATH = FILENAME + 1,
-        MAXRECENT = 10
+        MAXRECENT = 10,
+        MAXWARM = 5
     };
     explicit MainWindow(QWidget *parent = 0);
     ~MainWindow();
@@ -63,6 +70,13 @@ public:
     void closeFilesFromLoader(PluginInterface* loader);
     QString cleanPath(const QString& currentFile);
 
+    // The open document at file, NULL if it isn't open
+    DocumentBase* document(const QString& file);
+    // Makes the open document at file the current one, as picking it in the document list does
+    bool activateDocument(const QString& file);
+    // Save As without the dialog, saves in place if file is the current path
+    bool saveCurrentAs(const QString& file);
+
     bool isInternalBuild();
     bool isPreviewBuild();
 
@@ -79,11 +93,11 @@ public:
     QDir            engineDataPath()  const;
     QUrl            engineExecutable()const;
     QDir            homePath()        const;
+    TraceInterface* tracer()          const;
 
 public slots:
     void onNewDocument(DocumentBase* document);
-    // Lock file
-    void onLockTimeout();
+    void openFiles(const QStringList& files);
 protected slots:
     void onDocumentChanged(int row);
     void onClose();
@@ -100,6 +114,10 @@ protected slots:
     void onCheckUpdate();
     void onReload();
     void onExportWiiSave();
+    void onBatchExportWiiSave();
+    void onFindInData();
+    void onOpenSearchResult(const QString& file);
+    void onSettingChanged(const QString& key, const QVariant& value);
 
     void onStyleChanged();
 
@@ -122,8 +140,7 @@ protected:
     void dropEvent(QDropEvent* e);
 private:
     void loadWiiKeys();
-    bool checkLock();
-    void createLock();
+    bool checkWiiKeys();
     void initUpdater();
     void restoreDefaultGeometry();
     void injectPreviewLabel();
@@ -132,31 +149,41 @@ private:
     void initFSWatcher();
     void openFile(const QString& currentFile);
     QString strippedName(const QString& fullFileName) const;
+    QString pluginName(DocumentBase* document) const;
     QString mostRecentDirectory();
     void updateRecentFileActions();
     void setupStyleActions();
+    // The open documents, saved as the session once closing them wasn't cancelled
+    QStringList sessionFiles() const;
+    void saveSession(const QStringList& files);
+    void warmPageCache();
 
     Ui::MainWindow *ui;
     DocumentBase*                m_currentFile;
 
     ApplicationLog*          m_applicationLog;
+    PerformanceDialog*       m_performanceDialog;
+    BatchExportDialog*       m_batchExportDialog;
+    SettingsStore*           m_settings;
+    SearchDock*              m_searchDock;
+    PageCacheWarmer*         m_pageCacheWarmer;
     PluginsManager*          m_pluginsManager;
     QFileSystemWatcher       m_fileSystemWatcher;
     QList<QAction*>          m_recentFileActions;
     QAction*                 m_recentFileSeparator;
     QMap<QString, DocumentBase*> m_documents;
     QStringList              m_fileFilters;
+    QDir                     m_engineDataPath;
+    QUrl                     m_engineExecutable;
     QByteArray               m_defaultWindowGeometry;
     QByteArray               m_defaultWindowState;
     AboutDialog*             m_aboutDialog;
     Updater*                 m_updater;
     PreferencesDialog*       m_preferencesDialog;
     QMessageBox              m_updateMBox;
-    QTimer                   m_lockTimer;
     bool                     m_cancelClose;
     WiiKeyManager*           m_keyManager;
     int                      m_untitledDocs;
-    bool                     m_haveLock;
 #if defined(SS_PREVIEW) || defined(SS_INTERNAL)
     QHBoxLayout*             m_previewLayout;
     QLabel*                  m_previewLabel;
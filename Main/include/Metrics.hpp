@@ -0,0 +1,149 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <QObject>
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+// Process wide registry of counters, gauges and latency histograms.
+// Metrics are created on first use and live until the application exits,
+// so the returned pointers can be kept. Recording is lock free.
+// Every metric can be broken down by plugin, an empty plugin name means
+// the metric isn't tied to one.
+class Metrics : public QObject
+{
+    Q_OBJECT
+public:
+    class Counter
+    {
+    public:
+        Counter();
+        void add(qint64 n = 1);
+        qint64 value() const;
+        void reset();
+    private:
+        QAtomicInteger<qint64> m_value;
+    };
+
+    class Gauge
+    {
+    public:
+        Gauge();
+        void set(qint64 value);
+        qint64 value() const;
+        void reset();
+    private:
+        QAtomicInteger<qint64> m_value;
+    };
+
+    // Log-linear buckets in the style of HdrHistogram, every power of two
+    // is split into 16 buckets, so any value is within 1/16 of its bucket.
+    // Values are in microseconds.
+    class Histogram
+    {
+    public:
+        Histogram();
+        void record(qint64 usecs);
+        qint64 count() const;
+        qint64 sum() const;
+        qint64 max() const;
+        qint64 quantile(double q) const;
+        void reset();
+
+        enum
+        {
+            SubBucketBits = 4,
+            SubBuckets    = 1 << SubBucketBits,
+            MaxExponent   = 40,
+            BucketCount   = (MaxExponent - SubBucketBits + 2) * SubBuckets
+        };
+
+        static int bucketIndex(qint64 value);
+        static qint64 bucketValue(int index);
+
+    private:
+        QAtomicInteger<qint64>  m_count;
+        QAtomicInteger<qint64>  m_sum;
+        QAtomicInteger<qint64>  m_max;
+        QAtomicInteger<quint32> m_buckets[BucketCount];
+    };
+
+    // Records the time until it goes out of scope into a histogram,
+    // as a span while tracing, and on the GUI thread names what the
+    // Watchdog reports if the scope stalls
+    class Timer
+    {
+    public:
+        explicit Timer(const QString& name, const QString& plugin = QString());
+        ~Timer();
+        void setPlugin(const QString& plugin);
+        qint64 elapsed() const;
+        // Records now instead of at the end of the scope, e.g. before waiting on the user
+        void finish();
+    private:
+        QString       m_name;
+        QString       m_plugin;
+        QElapsedTimer m_timer;
+        bool          m_finished;
+        bool          m_traced;
+        bool          m_watched;
+    };
+
+    enum Type
+    {
+        CounterType,
+        GaugeType,
+        HistogramType
+    };
+
+    struct Metric
+    {
+        QString name;
+        QString plugin;
+        Type    type;
+        void*   data;
+    };
+
+    static Metrics* instance();
+    ~Metrics();
+
+    Counter* counter(const QString& name, const QString& plugin = QString());
+    Gauge* gauge(const QString& name, const QString& plugin = QString());
+    Histogram* histogram(const QString& name, const QString& plugin = QString());
+
+    // Sorted by name, then plugin
+    QList<Metric> metrics() const;
+    void reset();
+
+    // Prometheus text exposition format, histograms are written as summaries in seconds
+    QString toPrometheus() const;
+
+private:
+    explicit Metrics();
+    void* find(const QString& name, const QString& plugin, Type type);
+
+    mutable QMutex           m_mutex;
+    QHash<QString, Metric>   m_metrics;
+    static Metrics*          m_instance;
+};
+
+#endif // METRICS_HPP
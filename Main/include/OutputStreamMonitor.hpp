@@ -4,8 +4,18 @@
 #include <iostream>
 #include <streambuf>
 #include <string>
+#include <QMutex>
 #include <QObject>
+#include <QStringList>
 
+// Takes over a std::ostream's buffer, everything written still goes to the
+// original buffer and complete lines are reported in messagesRecieved().
+// Text is passed on to the original buffer as soon as its newline is written,
+// text after the last newline waits in a fixed buffer for the rest of its line.
+// The lines are reported in batches, once per event loop pass from the
+// monitor's thread, or at once by the writer when MaxPendingLines are waiting.
+// Any thread may write to the stream, the buffer is guarded by a mutex so there
+// is deliberately no put area for the inline ostream paths to write into.
 class OutputStreamMonitor : public QObject, public std::basic_streambuf<char>
 {
     Q_OBJECT
@@ -14,16 +24,39 @@ public:
     ~OutputStreamMonitor();
 
 signals:
-    void messageRecieved(QString);
+    void messagesRecieved(QStringList);
+private slots:
+    void flush();
+
 protected:
     virtual int_type overflow(int_type v);
-
     virtual std::streamsize xsputn(const char *p, std::streamsize n);
+    virtual int sync();
 
 private:
+    enum
+    {
+        BufferSize = 4096,
+        MaxPendingLines = 1000
+    };
+
+    void write(const char* data, std::size_t size);
+    void append(const char* data, std::size_t size);
+    void process(const char* data, std::size_t size);
+    void processBuffer();
+    // Called with the mutex held, hands back a batch the caller has to emit
+    QStringList schedule();
+
     std::ostream &m_stream;
     std::streambuf *m_oldBuf;
-    std::string m_string;
+    QMutex m_mutex;
+    char m_buffer[BufferSize];
+    std::size_t m_buffered;
+    // Text after the last newline, waiting for the rest of its line
+    std::string m_partial;
+    // Complete lines not reported yet, and whether flush() is on its way
+    QStringList m_pending;
+    bool m_flushScheduled;
 };
 
 #endif // OUTPUTSTREAMMONITOR_HPP
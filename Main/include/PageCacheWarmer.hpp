@@ -0,0 +1,54 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+#ifndef PAGECACHEWARMER_HPP
+#define PAGECACHEWARMER_HPP
+
+#include <QThread>
+#include <QAtomicInt>
+#include <QStringList>
+
+// Asks the OS to pull the given files into the page cache on an idle
+// priority thread, so reopening recent files doesn't hit a cold disk.
+// The warmer backs off whenever a ForegroundIo guard is alive.
+class PageCacheWarmer : public QThread
+{
+    Q_OBJECT
+public:
+    class ForegroundIo
+    {
+    public:
+        ForegroundIo();
+        ~ForegroundIo();
+    };
+
+    explicit PageCacheWarmer(const QStringList& files, QObject* parent = 0);
+    ~PageCacheWarmer();
+
+    void stop();
+
+protected:
+    void run();
+
+private:
+    void warm(const QString& file);
+    void waitForForeground();
+
+    QStringList       m_files;
+    QAtomicInt        m_stop;
+    static QAtomicInt m_foregroundIo;
+};
+
+#endif // PAGECACHEWARMER_HPP
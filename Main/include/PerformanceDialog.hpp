@@ -0,0 +1,75 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+#ifndef PERFORMANCEDIALOG_HPP
+#define PERFORMANCEDIALOG_HPP
+
+#include <QDialog>
+#include <QTimer>
+
+namespace Ui {
+class PerformanceDialog;
+}
+
+// Shows everything recorded in Metrics, refreshed while the dialog is open
+class PerformanceDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    enum
+    {
+        MetricColumn,
+        PluginColumn,
+        CountColumn,
+        MeanColumn,
+        P50Column,
+        P90Column,
+        P99Column,
+        MaxColumn,
+        ColumnCount
+    };
+
+    enum
+    {
+        AllocationTagColumn,
+        AllocationsColumn,
+        AllocatedColumn,
+        LiveColumn,
+        PeakColumn
+    };
+
+    explicit PerformanceDialog(QWidget* parent = 0);
+    ~PerformanceDialog();
+
+protected:
+    void showEvent(QShowEvent* se);
+    void hideEvent(QHideEvent* he);
+
+private slots:
+    void updateMetrics();
+    void onReset();
+    void onSave();
+    void onTraceToggled(bool enabled);
+    void onSaveTrace();
+
+private:
+    void updateAllocations();
+
+    Ui::PerformanceDialog* ui;
+    QTimer                 m_refreshTimer;
+};
+
+#endif // PERFORMANCEDIALOG_HPP
@@ -0,0 +1,92 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+#ifndef PLUGINUSAGE_HPP
+#define PLUGINUSAGE_HPP
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSet>
+#include "AllocationProfiler.hpp"
+
+class PluginInterface;
+
+// Wall time and heap growth spent inside each plugin's initialize, canLoad,
+// loadFile, save and reload calls. Those all happen on the GUI thread,
+// which is the only thread this may be used from.
+// Heap growth is the change of the whole process' heap, so whatever other
+// threads allocate meanwhile is charged to the plugin as well.
+class PluginUsage : public QObject
+{
+    Q_OBJECT
+public:
+    struct Usage
+    {
+        Usage();
+        qint64 calls;
+        qint64 usecs;
+        qint64 heapGrowth;
+    };
+
+    enum Measure
+    {
+        TimeAndHeap,
+        // For calls made on every open, sampling the heap costs more than they do
+        TimeOnly
+    };
+
+    // Charges everything between construction and destruction to plugin
+    class Scope
+    {
+    public:
+        explicit Scope(PluginInterface* plugin, Measure measure = TimeAndHeap);
+        ~Scope();
+        // Charges the plugin now instead of at the end of the scope
+        void finish();
+    private:
+        QString       m_plugin;
+        QElapsedTimer m_timer;
+        qint64        m_heap;
+        // Allocations are tagged with the plugin's name
+        AllocationProfiler::Scope m_allocations;
+    };
+
+    static PluginUsage* instance();
+    ~PluginUsage();
+
+    Usage usage(const QString& plugin) const;
+    void reset();
+
+    // Bytes currently allocated from the heap, -1 where that's unknown
+    static qint64 heapInUse();
+
+signals:
+    // Emitted once per event loop iteration for every plugin that was charged
+    void usageChanged(const QString& plugin);
+
+private slots:
+    void emitUsageChanged();
+
+private:
+    explicit PluginUsage();
+    void add(const QString& plugin, qint64 usecs, qint64 heapGrowth);
+
+    QHash<QString, Usage> m_usage;
+    QSet<QString>         m_changed;
+    static PluginUsage*   m_instance;
+};
+
+#endif // PLUGINUSAGE_HPP
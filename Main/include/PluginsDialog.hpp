@@ -35,6 +35,8 @@ public:
     {
         NameColumn,
         VersionColumn,
+        TimeColumn,
+        HeapColumn,
         ExtensionColumn,
         EnabledColumn,
         ColumnCount
@@ -54,7 +56,12 @@ private slots:
     void onCheckUpdate();
     void onPluginWarning(QString warning);
     void onTimeOut();
+    void onUsageChanged(const QString& plugin);
+    void onResetUsage();
 private:
+    QTreeWidgetItem* findItem(const QString& name) const;
+    void updateUsage(QTreeWidgetItem* item);
+
     Ui::PluginsDialog *ui;
 
     PluginsManager* m_pluginsManager;
@@ -18,6 +18,7 @@
 
 #include <QObject>
 #include <QMap>
+#include <QDir>
 class PluginsDialog;
 class PluginInterface;
 class QPluginLoader;
@@ -37,6 +38,15 @@ public:
 
     PluginInterface* preferredPlugin(const QString& file);
     bool reloadByName(const QString& name);
+
+    // Adds a plugin that is already instantiated, loader is NULL for plugins
+    // that live in the application itself. Fails if the name is taken.
+    bool registerPlugin(PluginInterface* plugin, QPluginLoader* loader = NULL);
+    // Loads and registers the plugin library at path
+    bool loadPlugin(const QString& path);
+    // SAKURASUITE_PLUGIN_PATH if set, otherwise "plugins" next to the
+    // executable or in the home path
+    static QDir pluginsDirectory();
 signals:
 
 public slots:
@@ -31,11 +31,14 @@ private slots:
     void onDirButtonClicked();
     void onButtonClicked(QAbstractButton* button);
     void onLoadKeys();
+    void onLoadKeysDirectory();
+    void onConsoleActivated(int index);
     void onLoadMac();
 
 private:
     void saveSettings();
     void updateKeys();
+    void updateConsoles();
     void restoreParents();
     Ui::PreferencesDialog *ui;
     QString    m_currentStyle;
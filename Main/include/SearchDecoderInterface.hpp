@@ -0,0 +1,39 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+#ifndef SEARCHDECODERINTERFACE_HPP
+#define SEARCHDECODERINTERFACE_HPP
+
+#include <QtPlugin>
+#include <QByteArray>
+#include <QString>
+
+// Optional interface a plugin may implement alongside PluginInterface
+// (Q_INTERFACES(PluginInterface SearchDecoderInterface)) so that
+// "Find in Data" can look inside compressed or packed formats.
+// Both functions are called from the search thread pool and must be reentrant.
+class SearchDecoderInterface
+{
+public:
+    virtual ~SearchDecoderInterface() {}
+
+    virtual bool canDecode(const QString& filePath) const = 0;
+    virtual QByteArray decode(const QString& filePath) const = 0;
+};
+
+#define SearchDecoderInterface_iid "org.wiiking2.SakuraSuite.SearchDecoderInterface"
+Q_DECLARE_INTERFACE(SearchDecoderInterface, SearchDecoderInterface_iid)
+
+#endif // SEARCHDECODERINTERFACE_HPP
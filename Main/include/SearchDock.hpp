@@ -0,0 +1,63 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+#ifndef SEARCHDOCK_HPP
+#define SEARCHDOCK_HPP
+
+#include <QDockWidget>
+#include <QHash>
+#include "SearchService.hpp"
+
+namespace Ui {
+class SearchDock;
+}
+
+class MainWindow;
+class QTreeWidgetItem;
+
+class SearchDock : public QDockWidget
+{
+    Q_OBJECT
+
+public:
+    enum
+    {
+        FileColumn,
+        OffsetColumn,
+        PreviewColumn
+    };
+
+    explicit SearchDock(MainWindow* parent);
+    ~SearchDock();
+
+    void focusPattern();
+
+signals:
+    void openRequested(QString filePath);
+
+private slots:
+    void onSearch();
+    void onResultsFound(QList<SearchResult> results);
+    void onFinished(int filesSearched, int matches, qint64 elapsed);
+    void onItemActivated(QTreeWidgetItem* item, int column);
+
+private:
+    Ui::SearchDock*                 ui;
+    MainWindow*                     m_mainWindow;
+    SearchService*                  m_searchService;
+    QHash<QString, QTreeWidgetItem*> m_fileItems;
+};
+
+#endif // SEARCHDOCK_HPP
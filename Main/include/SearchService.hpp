@@ -0,0 +1,70 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+#ifndef SEARCHSERVICE_HPP
+#define SEARCHSERVICE_HPP
+
+#include <QObject>
+#include <QDir>
+#include <QList>
+#include <QMetaType>
+#include <QSharedPointer>
+#include <QThreadPool>
+
+class SearchDecoderInterface;
+struct SearchJob;
+
+struct SearchResult
+{
+    QString filePath;
+    qint64  offset;
+    QString preview;
+    bool    decoded;
+};
+
+Q_DECLARE_METATYPE(SearchResult)
+Q_DECLARE_METATYPE(QList<SearchResult>)
+
+// Scans every file below a directory for a byte pattern.
+// Files are memory mapped and searched on a private thread pool,
+// results are delivered per file through resultsFound as they are found.
+class SearchService : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SearchService(QObject* parent = 0);
+    ~SearchService();
+
+    bool isRunning() const;
+    void start(const QDir& root, const QByteArray& pattern, const QList<SearchDecoderInterface*>& decoders);
+
+public slots:
+    void cancel();
+
+signals:
+    void resultsFound(QList<SearchResult> results);
+    void finished(int filesSearched, int matches, qint64 elapsed);
+
+private slots:
+    void onResults(quint32 generation, QList<SearchResult> results);
+    void onJobFinished(quint32 generation, int filesSearched, int matches, qint64 elapsed);
+
+private:
+    QThreadPool                m_pool;
+    QSharedPointer<SearchJob>  m_job;
+    quint32                    m_generation;
+};
+
+#endif // SEARCHSERVICE_HPP
@@ -0,0 +1,80 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+
+#ifndef SESSIONRECORDER_HPP
+#define SESSIONRECORDER_HPP
+
+#include <QObject>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTimer>
+
+class DocumentBase;
+
+// Records what the user does with documents to a script that
+// sakurasuite_replay plays back to measure the editor end to end.
+// Started with SAKURASUITE_RECORD_SESSION=<file>. Every line of the script is
+// a JSON object with the msecs since recording started ("t"), the "action"
+// (open, switch, edit, save, saveAs, reload or close) and the "file", relative
+// to the engine data path when it is inside it. Bursts of modifications are
+// written as one edit with their "count". A saveAs has the new path in "to",
+// later actions refer to the document by it. Saves are recorded once they
+// succeeded.
+class SessionRecorder : public QObject
+{
+    Q_OBJECT
+public:
+    enum
+    {
+        // Modifications this close together belong to the same burst
+        BurstGap = 250
+    };
+
+    static SessionRecorder* instance();
+    ~SessionRecorder();
+
+    // Files inside basePath are recorded relative to it
+    bool start(const QString& fileName, const QString& basePath = QString());
+    void stop();
+    bool isRecording() const;
+
+    void record(const QString& action, const QString& file, const QString& to = QString());
+    // Records the document's modifications as edits
+    void watch(DocumentBase* document);
+
+private slots:
+    void onModified();
+    void flushEdits();
+
+private:
+    explicit SessionRecorder();
+    void write(qint64 time, const QString& action, const QString& file, int count = 0, const QString& to = QString());
+    QString scriptPath(const QString& file) const;
+
+    QFile         m_file;
+    QDir          m_base;
+    bool          m_relative;
+    QElapsedTimer m_clock;
+    QString       m_current;
+    QString       m_editFile;
+    int           m_edits;
+    qint64        m_editStart;
+    QTimer        m_editTimer;
+    static SessionRecorder* m_instance;
+};
+
+#endif // SESSIONRECORDER_HPP
@@ -0,0 +1,67 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+#ifndef SETTINGSSTORE_HPP
+#define SETTINGSSTORE_HPP
+
+#include <QObject>
+#include <QHash>
+#include <QReadWriteLock>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
+#include <QVariant>
+
+// In-memory copy of the application's QSettings.
+// Everything is read once on first use, reads never touch the backend,
+// and writes are collected and flushed together a short while later
+// (or on sync(), which runs automatically when the application quits).
+class SettingsStore : public QObject
+{
+    Q_OBJECT
+public:
+    static SettingsStore* instance();
+    ~SettingsStore();
+
+    QVariant value(const QString& key, const QVariant& defaultValue = QVariant()) const;
+
+    template <typename T>
+    T value(const QString& key, const T& defaultValue = T()) const
+    {
+        return value(key, QVariant::fromValue<T>(defaultValue)).template value<T>();
+    }
+
+    void setValue(const QString& key, const QVariant& value);
+    void remove(const QString& key);
+    bool contains(const QString& key) const;
+    QStringList allKeys() const;
+
+public slots:
+    void sync();
+
+signals:
+    void valueChanged(const QString& key, const QVariant& value);
+
+private:
+    explicit SettingsStore();
+
+    mutable QReadWriteLock   m_lock;
+    QHash<QString, QVariant> m_values;
+    QSet<QString>            m_dirty;
+    QTimer                   m_syncTimer;
+    static SettingsStore*    m_instance;
+};
+
+#endif // SETTINGSSTORE_HPP
@@ -0,0 +1,56 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+#ifndef SINGLEINSTANCE_HPP
+#define SINGLEINSTANCE_HPP
+
+#include <QObject>
+#include <QLockFile>
+#include <QStringList>
+
+class QLocalServer;
+class QLocalSocket;
+
+// Guarantees only one editor runs per user.
+// The first process holds a lock file for its whole lifetime and listens on a
+// local socket, later processes hand their file arguments over that socket and exit.
+// tryLock() is safe to call before QApplication is constructed, forward() needs it.
+class SingleInstance : public QObject
+{
+    Q_OBJECT
+public:
+    SingleInstance();
+    ~SingleInstance();
+
+    bool tryLock();
+    bool forward(const QStringList& files);
+    bool listen();
+
+signals:
+    void filesReceived(QStringList files);
+
+private slots:
+    void onNewConnection();
+    void onDisconnected();
+
+private:
+    void readFiles(QLocalSocket* socket);
+
+    QString       m_serverName;
+    QLockFile     m_lockFile;
+    QLocalServer* m_server;
+};
+
+#endif // SINGLEINSTANCE_HPP
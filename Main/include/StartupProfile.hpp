@@ -0,0 +1,54 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+
+#ifndef STARTUPPROFILE_HPP
+#define STARTUPPROFILE_HPP
+
+#include <QObject>
+#include <QList>
+#include <QPair>
+
+// Records when startup milestones are reached, on a steady clock every process
+// shares so a launcher can line them up with when it started the process.
+// Only enabled with SAKURASUITE_STARTUP_PROFILE=<file>: the milestones are
+// written there as JSON once the event loop first goes idle, then the editor quits.
+class StartupProfile : public QObject
+{
+    Q_OBJECT
+public:
+    static StartupProfile* instance();
+    ~StartupProfile();
+
+    bool isEnabled() const;
+    // Nanoseconds on the steady clock
+    static qint64 now();
+    void mark(const QString& milestone, qint64 time = now());
+    // Waits for the first time the event loop has nothing left to do
+    void finishOnIdle();
+
+private slots:
+    void onAboutToBlock();
+
+private:
+    StartupProfile();
+    bool write(QString* error);
+
+    QString m_fileName;
+    QList<QPair<QString, qint64> > m_marks;
+    static StartupProfile* m_instance;
+};
+
+#endif // STARTUPPROFILE_HPP
@@ -0,0 +1,91 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+
+#ifndef TRACEINTERFACE_HPP
+#define TRACEINTERFACE_HPP
+
+#include <QtPlugin>
+#include <QAtomicInt>
+#include <QObject>
+#include <QString>
+#include <QVariant>
+
+// Timeline of what the editor and its plugins are doing, saved as a
+// Chrome trace which chrome://tracing and Perfetto can open.
+// Every thread records into its own buffer, so recording never contends,
+// and while recording is off every call is a single relaxed load.
+// Names are copied, so they don't have to outlive the plugin.
+//
+// Plugins get the tracer with TraceInterface::find(mainWindow()):
+//     TraceInterface::Span span(m_tracer, "MyPlugin", "parse");
+class TraceInterface
+{
+public:
+    virtual ~TraceInterface() {}
+
+    bool isEnabled() const
+    {
+        return m_enabled.load();
+    }
+
+    // Spans nest and must be ended on the thread that began them
+    virtual void begin(const char* category, const char* name) = 0;
+    virtual void end() = 0;
+    virtual void counter(const char* name, qint64 value) = 0;
+    // Names the calling thread in the trace
+    virtual void setThreadName(const QString& name) = 0;
+
+    // Traces the rest of the scope, does nothing if tracer is NULL
+    class Span
+    {
+    public:
+        Span(TraceInterface* tracer, const char* category, const char* name)
+            : m_tracer(tracer && tracer->isEnabled() ? tracer : 0)
+        {
+            if (m_tracer)
+                m_tracer->begin(category, name);
+        }
+
+        ~Span()
+        {
+            if (m_tracer)
+                m_tracer->end();
+        }
+
+    private:
+        Q_DISABLE_COPY(Span)
+        TraceInterface* m_tracer;
+    };
+
+    // The main window publishes its tracer as the "tracer" property
+    static TraceInterface* find(QObject* mainWindow)
+    {
+        if (!mainWindow)
+            return 0;
+
+        return qobject_cast<TraceInterface*>(mainWindow->property("tracer").value<QObject*>());
+    }
+
+protected:
+    TraceInterface() : m_enabled(0) {}
+
+    QAtomicInt m_enabled;
+};
+
+#define TraceInterface_iid "org.wiiking2.SakuraSuite.TraceInterface"
+Q_DECLARE_INTERFACE(TraceInterface, TraceInterface_iid)
+
+#endif // TRACEINTERFACE_HPP
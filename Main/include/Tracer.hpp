@@ -0,0 +1,103 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+
+#ifndef TRACER_HPP
+#define TRACER_HPP
+
+#include "TraceInterface.hpp"
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QStringList>
+#include <QVector>
+
+// The editor's TraceInterface. Each thread gets a buffer the first time it
+// records, buffers are kept after their thread exits so its events can still
+// be saved. The mutex of a buffer is only ever contended by save() and clear().
+class QThread;
+
+class Tracer : public QObject, public TraceInterface
+{
+    Q_OBJECT
+    Q_INTERFACES(TraceInterface)
+public:
+    enum
+    {
+        // Events each thread keeps, later events are dropped and counted
+        MaxEventsPerThread = 1 << 20
+    };
+
+    // Not synchronized, main() creates the tracer before starting any other thread
+    static Tracer* instance();
+    ~Tracer();
+
+    void setEnabled(bool enabled);
+    void clear();
+    bool save(const QString& fileName, QString* error = 0);
+
+    void begin(const char* category, const char* name);
+    void end();
+    void counter(const char* name, qint64 value);
+    void setThreadName(const QString& name);
+    // Spans thread has begun but not ended yet, outermost first
+    QStringList openSpans(QThread* thread);
+
+    // For callers that only have a QString, the names are converted only while recording
+    void begin(const QString& category, const QString& name);
+
+private:
+    explicit Tracer();
+
+    struct Event
+    {
+        qint64  timestamp; // nsecs since the tracer was created
+        qint64  value;
+        quint32 category;
+        quint32 name;
+        char    phase;
+    };
+
+    struct ThreadBuffer
+    {
+        QMutex          mutex;
+        QThread*        thread;
+        int             id;
+        QString         name;
+        QVector<Event>  events;
+        quint64         dropped;
+        // Spans that began after the buffer filled up
+        int             droppedDepth;
+        // Spans recorded and not ended yet, an end is only recorded against one
+        int             depth;
+        // Names are interned per thread, looked up by address first
+        QList<QByteArray>            names;
+        QHash<const char*, quint32>  byAddress;
+        QHash<QByteArray, quint32>   byName;
+    };
+
+    ThreadBuffer* buffer();
+    void record(char phase, const char* category, const char* name, qint64 value);
+    static quint32 intern(ThreadBuffer* buffer, const char* name);
+
+    QElapsedTimer        m_clock;
+    QMutex               m_buffersMutex;
+    QList<ThreadBuffer*> m_buffers;
+    static Tracer*       m_instance;
+};
+
+#endif // TRACER_HPP
@@ -0,0 +1,90 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+
+#ifndef WATCHDOG_HPP
+#define WATCHDOG_HPP
+
+#include <QThread>
+#include <QAtomicInteger>
+#include <QAtomicPointer>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QStringList>
+#include <QTimer>
+#include <QWaitCondition>
+#include "Metrics.hpp"
+
+// Notices when the GUI thread stops processing events.
+// The GUI thread refreshes a heartbeat every HeartbeatInterval, the watchdog
+// thread checks it and once it is older than the "stallThreshold" setting
+// (in msecs, 0 turns the watchdog off) logs what the GUI thread is busy with:
+// the Metrics::Timer scopes it is in, the open trace spans, the last event
+// it was sent and, where supported, its stack.
+// Stalls are counted in sakurasuite_gui_stalls_total and their length
+// recorded in sakurasuite_gui_stall_seconds.
+class Watchdog : public QThread
+{
+    Q_OBJECT
+public:
+    enum
+    {
+        HeartbeatInterval = 100,
+        DefaultThreshold  = 500,
+        MaxFrames         = 64
+    };
+
+    // Must first be called from the GUI thread
+    static Watchdog* instance();
+    ~Watchdog();
+
+    void watch();
+    void stop();
+
+    // Names what the GUI thread is doing until the matching leave(),
+    // returns false and does nothing on any other thread
+    static bool enter(const QString& activity);
+    static void leave();
+
+protected:
+    void run();
+    bool eventFilter(QObject* object, QEvent* event);
+
+private slots:
+    void onHeartbeat();
+    void onSettingChanged(const QString& key, const QVariant& value);
+
+private:
+    explicit Watchdog();
+    void reportStall(qint64 msecs);
+    QStringList guiThreadStack();
+
+    QElapsedTimer                     m_clock;
+    QTimer                            m_heartbeatTimer;
+    QAtomicInteger<qint64>            m_heartbeat;
+    QAtomicInt                        m_threshold;
+    // The last event sent on the GUI thread
+    QAtomicPointer<const QMetaObject> m_receiver;
+    QAtomicInt                        m_eventType;
+    QMutex                            m_mutex;
+    QWaitCondition                    m_wake;
+    QStringList                       m_activities;
+    bool                              m_stop;
+    Metrics::Counter*                 m_stalls;
+    Metrics::Histogram*               m_stallTimes;
+    static QAtomicPointer<Watchdog>   m_instance;
+};
+
+#endif // WATCHDOG_HPP
@@ -3,14 +3,34 @@
 
 #include <WiiKeyManagerBase.hpp>
 #include <QObject>
+#include <QMap>
 #include <MainWindow.hpp>
 
 class WiiKeyManager : public WiiKeyManagerBase
 {
 public:
+    // What a BackupMii keys.bin dump holds for one console
+    struct Keys
+    {
+        Keys();
+        quint32    ngId;
+        quint32    ngKeyId;
+        QByteArray ngPriv;
+        QByteArray ngSig;
+    };
+
     WiiKeyManager(MainWindow* mainWindow);
     ~WiiKeyManager();
+    // Keys that are already set are kept unless clear is true
     bool open(const QString& filepath, bool clear = false);
+    // Loads every dump in directory, returns how many were loaded.
+    // Their consoles are kept in memory so selectConsole doesn't touch the disk.
+    int openDirectory(const QString& directory);
+    // NG IDs of the consoles loaded so far
+    QList<quint32> consoles() const;
+    // Replaces every key but the MAC address, which dumps don't have
+    bool selectConsole(quint32 ngId);
+    static bool parseDump(const QByteArray& dump, Keys& keys, QString* error = 0);
     bool loadKeys();
     void saveKeys();
 
@@ -29,12 +49,16 @@ public:
     void       setMacAddr(const QByteArray& mac);
 
 private:
+    bool readDump(const QString& filepath, Keys& keys);
+    void setKeys(const Keys& keys);
+
     char*   m_ngPriv;
     char*   m_ngSig;
     char*   m_macAddr;
     quint32 m_ngId;
     quint32 m_ngKeyId;
     bool    m_open;
+    QMap<quint32, Keys> m_consoles;
     MainWindow* m_mainWindow;
 };
 
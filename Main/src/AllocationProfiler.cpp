@@ -0,0 +1,342 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+
+#include "AllocationProfiler.hpp"
+#include <QStringList>
+#include <algorithm>
+
+#ifdef SS_ALLOC_PROFILING
+#include <QAtomicInteger>
+#include <QMutex>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Only glibc supports replacing malloc, which catches everything including
+// QString and the containers. A replaced operator new alone would also see
+// blocks from other modules' allocators, corrupting their heaps on Windows.
+#if !defined(Q_OS_LINUX) || !defined(__GLIBC__)
+#error "SS_ALLOC_PROFILING needs glibc"
+#endif
+
+extern "C"
+{
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* pointer, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void  __libc_free(void* pointer);
+}
+
+namespace
+{
+struct Counters
+{
+    QAtomicInteger<qint64> allocations;
+    QAtomicInteger<qint64> bytes;
+    QAtomicInteger<qint64> live;
+    QAtomicInteger<qint64> peak;
+};
+
+struct Tag
+{
+    const char* key;
+    char        name[64];
+};
+
+// Written once per tag under tagMutex and published by tagCount,
+// nothing here may allocate while a hook runs
+Counters       counters[AllocationProfiler::MaxTags];
+Tag            tags[AllocationProfiler::MaxTags] = {{NULL, "untagged"}};
+QBasicAtomicInt tagCount = Q_BASIC_ATOMIC_INITIALIZER(1);
+QMutex         tagMutex;
+thread_local int currentTag = 0;
+
+// In front of every block, 16 bytes keeps the block 16 byte aligned
+struct Header
+{
+    size_t  size;
+    quint32 tag;
+    // From the start of what was really allocated to the block
+    quint32 offset;
+};
+const size_t HeaderSize = 16;
+static_assert(sizeof(Header) <= HeaderSize, "the header must fit in front of the block");
+
+int findTag(const char* key, const char* name)
+{
+    int count = tagCount.loadAcquire();
+    for (int i = 0; key && i < count; i++)
+    {
+        // Literals of unloaded plugins may be replaced by something else at the same address
+        if (tags[i].key == key && !strcmp(tags[i].name, name))
+            return i;
+    }
+
+    QMutexLocker locker(&tagMutex);
+    count = tagCount.loadAcquire();
+    for (int i = 0; i < count; i++)
+    {
+        if (!strncmp(tags[i].name, name, sizeof(tags[i].name) - 1))
+            return i;
+    }
+
+    // Out of tags, count it as untagged rather than lose it
+    if (count == AllocationProfiler::MaxTags)
+        return 0;
+
+    tags[count].key = key;
+    qstrncpy(tags[count].name, name, sizeof(tags[count].name));
+    tagCount.storeRelease(count + 1);
+    return count;
+}
+
+inline Header* header(void* block)
+{
+    return reinterpret_cast<Header*>(static_cast<char*>(block) - HeaderSize);
+}
+
+inline void* track(void* base, size_t size, size_t offset)
+{
+    if (!base)
+        return NULL;
+
+    void* block = static_cast<char*>(base) + offset;
+    Header* h = header(block);
+    h->size = size;
+    h->tag = currentTag;
+    h->offset = offset;
+
+    Counters& c = counters[h->tag];
+    c.allocations.fetchAndAddRelaxed(1);
+    c.bytes.fetchAndAddRelaxed(size);
+    qint64 live = c.live.fetchAndAddRelaxed(size) + size;
+    qint64 peak = c.peak.loadAcquire();
+    while (live > peak && !c.peak.testAndSetRelaxed(peak, live, peak))
+        ;
+    return block;
+}
+
+// Returns what was really allocated
+inline void* untrack(void* block)
+{
+    Header* h = header(block);
+    counters[h->tag].live.fetchAndAddRelaxed(-(qint64)h->size);
+    return static_cast<char*>(block) - h->offset;
+}
+
+void* alignedAllocate(size_t alignment, size_t size)
+{
+    // The header goes in the padding in front of the block
+    size_t offset = qMax(alignment, HeaderSize);
+    if (size > (size_t)-1 - offset)
+        return NULL;
+    return track(__libc_memalign(alignment, size + offset), size, offset);
+}
+}
+
+extern "C"
+{
+void* malloc(size_t size)
+{
+    if (size > (size_t)-1 - HeaderSize)
+        return NULL;
+    return track(__libc_malloc(size + HeaderSize), size, HeaderSize);
+}
+
+void free(void* block)
+{
+    if (block)
+        __libc_free(untrack(block));
+}
+
+void* calloc(size_t count, size_t size)
+{
+    if (size && count > ((size_t)-1 - HeaderSize) / size)
+        return NULL;
+    return track(__libc_calloc(1, count * size + HeaderSize), count * size, HeaderSize);
+}
+
+void* realloc(void* block, size_t size)
+{
+    if (!block)
+        return malloc(size);
+    if (!size)
+    {
+        free(block);
+        return NULL;
+    }
+
+    Header old = *header(block);
+    if (old.offset != HeaderSize || size > (size_t)-1 - HeaderSize)
+    {
+        // Aligned blocks can't be resized in place with their header
+        void* resized = malloc(size);
+        if (resized)
+        {
+            memcpy(resized, block, qMin(size, old.size));
+            free(block);
+        }
+        return resized;
+    }
+
+    void* base = __libc_realloc(static_cast<char*>(block) - HeaderSize, size + HeaderSize);
+    if (!base)
+        return NULL;
+
+    // Counted as a new allocation by whoever resized it
+    counters[old.tag].live.fetchAndAddRelaxed(-(qint64)old.size);
+    return track(base, size, HeaderSize);
+}
+
+void* reallocarray(void* block, size_t count, size_t size)
+{
+    if (size && count > (size_t)-1 / size)
+    {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return realloc(block, count * size);
+}
+
+void* memalign(size_t alignment, size_t size)
+{
+    return alignedAllocate(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size)
+{
+    return alignedAllocate(alignment, size);
+}
+
+int posix_memalign(void** block, size_t alignment, size_t size)
+{
+    if (!alignment || (alignment & (alignment - 1)) || alignment % sizeof(void*))
+        return EINVAL;
+
+    void* allocated = alignedAllocate(alignment, size);
+    if (!allocated)
+        return ENOMEM;
+    *block = allocated;
+    return 0;
+}
+
+void* valloc(size_t size)
+{
+    return alignedAllocate(sysconf(_SC_PAGESIZE), size);
+}
+
+void* pvalloc(size_t size)
+{
+    size_t page = sysconf(_SC_PAGESIZE);
+    return alignedAllocate(page, (size + page - 1) & ~(page - 1));
+}
+
+size_t malloc_usable_size(void* block)
+{
+    return block ? header(block)->size : 0;
+}
+}
+
+AllocationProfiler::Scope::Scope(const char* tag)
+    : m_previous(currentTag)
+{
+    currentTag = findTag(tag, tag);
+}
+
+AllocationProfiler::Scope::Scope(const QString& tag)
+    : m_previous(currentTag)
+{
+    // The conversion is still counted against the enclosing scope,
+    // an empty tag leaves it in place
+    if (!tag.isEmpty())
+        currentTag = findTag(NULL, tag.toUtf8().constData());
+}
+
+AllocationProfiler::Scope::~Scope()
+{
+    currentTag = m_previous;
+}
+
+bool AllocationProfiler::isEnabled()
+{
+    return true;
+}
+#else
+bool AllocationProfiler::isEnabled()
+{
+    return false;
+}
+#endif
+
+AllocationProfiler::Usage::Usage()
+    : allocations(0),
+      bytes(0),
+      live(0),
+      peak(0)
+{
+}
+
+QList<AllocationProfiler::Usage> AllocationProfiler::usage()
+{
+    QList<Usage> usage;
+#ifdef SS_ALLOC_PROFILING
+    int count = tagCount.loadAcquire();
+    for (int i = 0; i < count; i++)
+    {
+        Usage tag;
+        tag.tag = QString::fromUtf8(tags[i].name);
+        tag.allocations = counters[i].allocations.loadAcquire();
+        tag.bytes = counters[i].bytes.loadAcquire();
+        tag.live = counters[i].live.loadAcquire();
+        tag.peak = counters[i].peak.loadAcquire();
+        usage << tag;
+    }
+
+    std::sort(usage.begin(), usage.end(), [](const Usage& a, const Usage& b) { return a.bytes > b.bytes; });
+#endif
+    return usage;
+}
+
+void AllocationProfiler::reset()
+{
+#ifdef SS_ALLOC_PROFILING
+    int count = tagCount.loadAcquire();
+    for (int i = 0; i < count; i++)
+    {
+        counters[i].allocations.storeRelease(0);
+        counters[i].bytes.storeRelease(0);
+        counters[i].peak.storeRelease(counters[i].live.loadAcquire());
+    }
+#endif
+}
+
+QString AllocationProfiler::report()
+{
+    QStringList lines;
+    lines << QString("%1 %2 %3 %4 %5").arg("Tag", -32).arg("Allocations", 14).arg("Allocated KiB", 14)
+                                      .arg("Live KiB", 12).arg("Peak KiB", 12);
+    foreach (const Usage& tag, usage())
+    {
+        lines << QString("%1 %2 %3 %4 %5").arg(tag.tag, -32).arg(tag.allocations, 14)
+                                          .arg(tag.bytes / 1024.0, 14, 'f', 1)
+                                          .arg(tag.live / 1024.0, 12, 'f', 1)
+                                          .arg(tag.peak / 1024.0, 12, 'f', 1);
+    }
+
+    return lines.join('\n');
+}
@@ -1,28 +1,110 @@
 #include "ApplicationLog.hpp"
 #include "ui_ApplicationLog.h"
+#include "LogModel.hpp"
+#include "LogFilter.hpp"
 #include <QAbstractButton>
 #include <QDebug>
 #include <QFileDialog>
+#include <QStyle>
+#include <QShowEvent>
+#include <QThread>
+#include <QCoreApplication>
 #include "Constants.hpp"
+#include "SettingsStore.hpp"
+#include "AllocationProfiler.hpp"
 #include <iostream>
 
+namespace
+{
+const int DefaultCapacity = 100000;
+// Only the newest rows of a large batch are measured when sizing the columns
+const int MaxMeasuredRows = 512;
+// Messages per second and burst size allowed for a single source location
+const double RateLimit = 50.0;
+const double RateBurst = 200.0;
+// Everything logged without a location shares one source, captured output
+// and plugins built without QT_MESSAGELOGCONTEXT, so it gets more room
+const double UnlocatedRateLimit = 500.0;
+const double UnlocatedRateBurst = 2000.0;
+// How long dropped messages wait to be counted in the log if their source goes quiet
+const int SuppressedReportDelay = 1000;
+// Typing into the filter fields waits this long before searching
+const int FilterDelay = 250;
+// How often "last N minutes" drops the entries that have become too old
+const int SinceUpdateInterval = 5000;
+
+// SAKURASUITE_LOG_PATH keeps tools like the benchmarks out of the user's logs
+QString logPath()
+{
+    QByteArray path = qgetenv("SAKURASUITE_LOG_PATH");
+    if (!path.isEmpty())
+        return QString::fromLocal8Bit(path);
+
+    return Constants::SAKURASUITE_HOME_PATH;
+}
+}
+
+ApplicationLog::Bucket::Bucket()
+    : tokens(RateBurst),
+      lastRefill(0),
+      suppressed(0)
+{
+}
+
 ApplicationLog* ApplicationLog::m_instance = NULL;
 ApplicationLog::ApplicationLog() :
     ui(new Ui::ApplicationLog),
+    m_messages(SettingsStore::instance()->value<int>(Constants::Settings::SAKURASUITE_LOG_CAPACITY, DefaultCapacity)),
+    m_model(NULL),
+    m_messageWidth(0),
+    m_spillEvicted(SettingsStore::instance()->value<bool>(Constants::Settings::SAKURASUITE_LOG_SPILL_EVICTED, false)),
+    m_spillFile(logPath() + QDir::separator() + "evicted.log"),
+    m_writer(logPath() + QDir::separator() + "sakurasuite.log"),
+    m_unreportedRepeats(0),
+    m_drainScheduled(0),
     m_stdoutMonitor(std::cout),
     m_stdlogMonitor(std::clog),
     m_stderrMonitor(std::cerr)
 {
     ui->setupUi(this);
-    connect(&m_stdoutMonitor, SIGNAL(messageRecieved(QString)), this, SLOT(onStdOut(QString)));
-    connect(&m_stdlogMonitor, SIGNAL(messageRecieved(QString)), this, SLOT(onStdLog(QString)));
-    connect(&m_stderrMonitor, SIGNAL(messageRecieved(QString)), this, SLOT(onStdErr(QString)));
+    m_writer.start(QThread::LowPriority);
+    m_model = new LogModel(&m_messages, &m_index, this);
+    ui->treeView->setModel(m_model);
+    // The date column is always the same width, no need to measure it per row
+    ui->treeView->header()->resizeSection(LogModel::DateTimeColumn,
+                                          ui->treeView->fontMetrics().width(QDateTime::currentDateTime().toString()) + 16);
+    connect(m_model, SIGNAL(rowsInserted(QModelIndex,int,int)), this, SLOT(onRowsInserted(QModelIndex,int,int)));
+
+    m_filterTimer.setSingleShot(true);
+    m_filterTimer.setInterval(FilterDelay);
+    connect(&m_filterTimer, SIGNAL(timeout()), this, SLOT(applyFilter()));
+    m_sinceTimer.setInterval(SinceUpdateInterval);
+    connect(&m_sinceTimer, SIGNAL(timeout()), this, SLOT(updateSince()));
+    m_suppressedTimer.setSingleShot(true);
+    m_suppressedTimer.setInterval(SuppressedReportDelay);
+    connect(&m_suppressedTimer, SIGNAL(timeout()), this, SLOT(reportAllSuppressed()));
+    connect(ui->levelComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(onFilterChanged()));
+    connect(ui->timeComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(onFilterChanged()));
+    connect(ui->fileComboBox, SIGNAL(editTextChanged(QString)), this, SLOT(onFilterChanged()));
+    connect(ui->searchLineEdit, SIGNAL(textChanged(QString)), this, SLOT(onFilterChanged()));
+
+    LogFilter::setRules(SettingsStore::instance()->value<QString>(Constants::Settings::SAKURASUITE_LOG_LEVELS));
+    connect(SettingsStore::instance(), SIGNAL(valueChanged(QString,QVariant)), this, SLOT(onSettingChanged(QString,QVariant)));
+    // The streams can be written from any thread, queue their lines right there
+    connect(&m_stdoutMonitor, SIGNAL(messagesRecieved(QStringList)), this, SLOT(onStdOut(QStringList)), Qt::DirectConnection);
+    connect(&m_stdlogMonitor, SIGNAL(messagesRecieved(QStringList)), this, SLOT(onStdLog(QStringList)), Qt::DirectConnection);
+    connect(&m_stderrMonitor, SIGNAL(messagesRecieved(QStringList)), this, SLOT(onStdErr(QStringList)), Qt::DirectConnection);
 }
 
 ApplicationLog::~ApplicationLog()
 {
-    saveLog(Constants::SAKURASUITE_HOME_PATH + QDir::separator() + "shutdown.log");
     qInstallMessageHandler(0);
+    // Everything is already on its way to the log file, only what's queued
+    // and the counts of repeated and suppressed messages are left
+    reportAllSuppressed();
+    m_writer.stop();
+    m_writer.wait();
+    m_instance = NULL;
     delete ui;
     ui = NULL;
 }
@@ -34,24 +116,97 @@ ApplicationLog*ApplicationLog::instance()
     return m_instance;
 }
 
+void ApplicationLog::addMessage(ApplicationLog::Level level, const QMessageLogContext& context, const QString& message)
+{
+    AllocationProfiler::Scope allocations("log");
+    post(level, message, context.file, context.line, context.function);
+}
+
 void ApplicationLog::debug(const QString& message)
 {
-    addEntry(Debug, message);
+    post(Debug, message);
 }
 
 void ApplicationLog::warning(const QString& warning)
 {
-    addEntry(Warning, warning);
+    post(Warning, warning);
 }
 
 void ApplicationLog::error(const QString& error)
 {
-    addEntry(Error, error);
+    post(Error, error);
 }
 
 void ApplicationLog::fatal(const QString& fatal)
 {
-    addEntry(Fatal, fatal);
+    post(Fatal, fatal);
+}
+
+void ApplicationLog::post(ApplicationLog::Level level, const QString& message, const char* file, int line, const char* function)
+{
+    const qint64 timestamp = QDateTime::currentMSecsSinceEpoch();
+    LogQueue::Node* node = LogQueue::allocate();
+    node->timestamp = timestamp;
+    node->level = level;
+    node->file = file;
+    node->line = line;
+    node->function = function;
+    node->message = message;
+    m_queue.push(node);
+
+    // The process is about to abort, get the message to disk while we still can
+    if (level == Fatal)
+    {
+        if (QThread::currentThread() == thread())
+            drain();
+        else
+            m_writer.write(QVector<LogWriter::Record>() << LogWriter::Record{timestamp, Fatal, QString(), message});
+        m_writer.flush();
+        return;
+    }
+
+    // Only the first message of a batch wakes up the GUI thread
+    if (m_drainScheduled.testAndSetOrdered(0, 1))
+        QMetaObject::invokeMethod(this, "drain", Qt::QueuedConnection);
+}
+
+void ApplicationLog::drain()
+{
+    AllocationProfiler::Scope allocations("log");
+    m_drainScheduled.store(0);
+
+    // Formatting for the log file happens on the writer's thread
+    QVector<LogWriter::Record> records;
+    while (LogQueue::Node* node = m_queue.pop())
+    {
+        Level level = (Level)node->level;
+        quint32 source = m_messages.intern(node->file, node->line, node->function);
+        if (isRepeat(level, node->message, source))
+        {
+            m_messages.repeatLast(node->timestamp);
+            m_unreportedRepeats++;
+            if (ui)
+                m_model->entryRepeated();
+        }
+        else
+        {
+            reportRepeats(records);
+            if (takeToken(level, source, node->timestamp, records))
+            {
+                addEntry(level, node->message, source, node->timestamp);
+                records << LogWriter::Record{node->timestamp, node->level, m_messages.location(source), node->message};
+            }
+        }
+
+        LogQueue::release(node);
+    }
+
+    if (!records.isEmpty())
+        m_writer.write(records);
+
+    // A producer was interrupted halfway through a push, pick it up on the next pass
+    if (!m_queue.isEmpty() && m_drainScheduled.testAndSetOrdered(0, 1))
+        QMetaObject::invokeMethod(this, "drain", Qt::QueuedConnection);
 }
 
 void ApplicationLog::saveLog(const QString& logFilename)
@@ -72,35 +227,147 @@ void ApplicationLog::saveLog(const QString& logFilename)
         stream << "Built " << Constants::SAKURASUITE_BUILD_DATE << "\n";
         stream << "Version " << Constants::SAKURASUITE_APP_VERSION << "\n";
 
-        foreach (Entry entry, m_messages)
-        {
-            switch (entry.level)
-            {
-                case Debug:
-                    stream << "[Debug  ]: ";
-                    break;
-                case Warning:
-                    stream << "[Warning]: ";
-                    break;
-                case Error:
-                    stream << "[Error  ]: ";
-                    break;
-                case Fatal:
-                    stream << "[Fatal  ]: ";
-                    break;
-            }
+        m_model->flush();
+        if (!m_model->query().isEmpty())
+            stream << "Filtered, " << m_model->rowCount() << " of " << m_messages.count() << " entries\n";
 
-            stream << entry.dateTime.toLocalTime().toString() << " ";
-            stream << entry.message << "\n";
+        for (int row = 0; row < m_model->rowCount(); row++)
+        {
+            if (const LogBuffer::Entry* entry = m_model->entry(row))
+                stream << formatEntry(*entry) << "\n";
         }
     }
 }
 
+bool ApplicationLog::isRepeat(ApplicationLog::Level level, const QString& message, quint32 source) const
+{
+    if (m_messages.isEmpty())
+        return false;
+
+    const LogBuffer::Entry& last = m_messages.last();
+    return last.level == level && last.source == source && last.message == message;
+}
+
+void ApplicationLog::reportRepeats(QVector<LogWriter::Record>& records)
+{
+    if (m_unreportedRepeats == 0 || m_messages.isEmpty())
+        return;
+
+    const LogBuffer::Entry& last = m_messages.last();
+    records << LogWriter::Record{last.lastSeen, last.level, m_messages.location(last.source),
+                                 QString("Previous message repeated %1 more times").arg(m_unreportedRepeats)};
+    m_unreportedRepeats = 0;
+}
+
+bool ApplicationLog::takeToken(ApplicationLog::Level level, quint32 source, qint64 timestamp, QVector<LogWriter::Record>& records)
+{
+    // Errors are never worth losing
+    if (level >= Error)
+        return true;
+
+    if ((quint32)m_buckets.size() <= source)
+        m_buckets.resize(source + 1);
+
+    const double rate = source == 0 ? UnlocatedRateLimit : RateLimit;
+    const double burst = source == 0 ? UnlocatedRateBurst : RateBurst;
+    Bucket& bucket = m_buckets[source];
+    bucket.tokens = qMin(burst, bucket.tokens + (timestamp - bucket.lastRefill) * rate / 1000.0);
+    bucket.lastRefill = timestamp;
+    if (bucket.tokens < 1.0)
+    {
+        bucket.suppressed++;
+        // The source may never log again, report what was dropped in a while either way
+        if (!m_suppressedTimer.isActive())
+            m_suppressedTimer.start();
+        return false;
+    }
+
+    bucket.tokens -= 1.0;
+    reportSuppressed(source, timestamp, records);
+    return true;
+}
+
+void ApplicationLog::reportSuppressed(quint32 source, qint64 timestamp, QVector<LogWriter::Record>& records)
+{
+    Bucket& bucket = m_buckets[source];
+    if (bucket.suppressed == 0)
+        return;
+
+    QString message = source == 0 ? QString("%1 messages without a location were suppressed").arg(bucket.suppressed)
+                                  : QString("%1 messages from this location were suppressed").arg(bucket.suppressed);
+    addEntry(Warning, message, source, timestamp);
+    records << LogWriter::Record{timestamp, Warning, m_messages.location(source), message};
+    bucket.suppressed = 0;
+}
+
+void ApplicationLog::reportAllSuppressed()
+{
+    // Anything still queued may take a token and report its own source first
+    drain();
+
+    const qint64 timestamp = QDateTime::currentMSecsSinceEpoch();
+    QVector<LogWriter::Record> records;
+    reportRepeats(records);
+    for (int source = 0; source < m_buckets.size(); source++)
+        reportSuppressed(source, timestamp, records);
+
+    if (!records.isEmpty())
+        m_writer.write(records);
+}
+
+QString ApplicationLog::formatEntry(const LogBuffer::Entry& entry) const
+{
+    QString message = entry.message;
+    if (entry.count > 1)
+        message += QString(" (repeated %1 times, last at %2)").arg(entry.count)
+                .arg(QDateTime::fromMSecsSinceEpoch(entry.lastSeen).toLocalTime().toString());
+
+    return formatEntry(entry.timestamp, entry.level, m_messages.location(entry.source), message);
+}
+
+QString ApplicationLog::formatEntry(qint64 timestamp, quint8 level, const QString& location, const QString& message)
+{
+    QString levelString;
+    switch (level)
+    {
+        case Debug:
+            levelString = "[Debug  ]: ";
+            break;
+        case Warning:
+            levelString = "[Warning]: ";
+            break;
+        case Error:
+            levelString = "[Error  ]: ";
+            break;
+        case Fatal:
+            levelString = "[Fatal  ]: ";
+            break;
+    }
+
+    QString dateTime = QDateTime::fromMSecsSinceEpoch(timestamp).toLocalTime().toString();
+    if (location.isEmpty())
+        return QString("%1%2 %3").arg(levelString).arg(dateTime).arg(message);
+
+    return QString("%1%2 [%3]: %4").arg(levelString).arg(dateTime).arg(location).arg(message);
+}
+
+void ApplicationLog::spill(const LogBuffer::Entry& entry)
+{
+    if (!m_spillFile.isOpen() && !m_spillFile.open(QFile::WriteOnly | QFile::Truncate | QFile::Text))
+    {
+        m_spillEvicted = false;
+        return;
+    }
+
+    m_spillFile.write(formatEntry(entry).toUtf8());
+    m_spillFile.write("\n");
+}
+
 void ApplicationLog::onButtonPressed()
 {
     if (sender() == ui->saveLogPushButton)
     {
-        QString rd = QSettings().value(Constants::Settings::SAKURASUITE_RECENT_DIRECTORY).toString();
+        QString rd = SettingsStore::instance()->value<QString>(Constants::Settings::SAKURASUITE_RECENT_DIRECTORY);
         QString logFilename = QFileDialog::getSaveFileName(this, "Save log...", rd, "*.log");
         if (logFilename.isEmpty())
             return;
@@ -108,49 +375,130 @@ void ApplicationLog::onButtonPressed()
         if (QFileInfo(logFilename).suffix() != "log")
             logFilename += ".log";
 
-        QSettings().setValue(Constants::Settings::SAKURASUITE_RECENT_DIRECTORY, QFileInfo(logFilename).absolutePath());
+        SettingsStore::instance()->setValue(Constants::Settings::SAKURASUITE_RECENT_DIRECTORY, QFileInfo(logFilename).absolutePath());
         saveLog(logFilename);
     }
 }
 
-void ApplicationLog::onStdOut(QString msg)
+void ApplicationLog::onStdOut(QStringList lines)
 {
-    debug(QString("[stdout] %1").arg(msg));
+    foreach (const QString& line, lines)
+        debug(QString("[stdout] %1").arg(line));
 }
 
-void ApplicationLog::onStdLog(QString msg)
+void ApplicationLog::onStdLog(QStringList lines)
 {
-    debug(QString("[stdlog] %1").arg(msg));
+    foreach (const QString& line, lines)
+        debug(QString("[stdlog] %1").arg(line));
 }
 
-void ApplicationLog::onStdErr(QString msg)
+void ApplicationLog::onStdErr(QStringList lines)
 {
-    error(QString("[stderr] %1").arg(msg));
+    foreach (const QString& line, lines)
+        error(QString("[stderr] %1").arg(line));
 }
 
-void ApplicationLog::addEntry(ApplicationLog::Level level, const QString& message)
+void ApplicationLog::addEntry(ApplicationLog::Level level, const QString& message, quint32 source, qint64 timestamp)
 {
-    m_messages << Entry{level, QDateTime::currentDateTime(), message};
+    LogBuffer::Entry entry = {timestamp, source, (quint8)level, message, 1, timestamp};
+    LogBuffer::Entry evicted;
+    bool wasEvicted = m_messages.append(entry, &evicted);
+    if (wasEvicted && m_spillEvicted)
+        spill(evicted);
+
+    m_index.append(m_messages.firstSequence() + m_messages.count() - 1, level, m_messages.source(source).file);
+    if (wasEvicted)
+        m_index.prune(m_messages.firstSequence());
+
     if (!ui)
         return;
 
-    QTreeWidgetItem* item = new QTreeWidgetItem;
-    switch(level)
+    m_model->entryAppended();
+}
+
+void ApplicationLog::onFilterChanged()
+{
+    m_filterTimer.start();
+}
+
+void ApplicationLog::applyFilter()
+{
+    LogIndex::Query query;
+    query.minimumLevel = ui->levelComboBox->currentIndex();
+    query.file = ui->fileComboBox->currentText().trimmed();
+    query.text = ui->searchLineEdit->text();
+    query.since = since();
+    m_model->setQuery(query);
+
+    // Move the start of the time window along while the dialog is open
+    if (query.since > 0 && isVisible())
+        m_sinceTimer.start();
+    else
+        m_sinceTimer.stop();
+}
+
+void ApplicationLog::updateSince()
+{
+    m_model->setSince(since());
+}
+
+qint64 ApplicationLog::since() const
+{
+    static const int sinceSeconds[] = {0, 60, 10 * 60, 60 * 60};
+    int seconds = sinceSeconds[qBound(0, ui->timeComboBox->currentIndex(), 3)];
+    if (seconds == 0)
+        return 0;
+
+    return QDateTime::currentMSecsSinceEpoch() - seconds * 1000;
+}
+
+void ApplicationLog::showEvent(QShowEvent* event)
+{
+    // Offer the source files seen so far without losing what was typed
+    QString file = ui->fileComboBox->currentText();
+    ui->fileComboBox->blockSignals(true);
+    ui->fileComboBox->clear();
+    ui->fileComboBox->addItem(QString());
+    ui->fileComboBox->addItems(m_index.files());
+    ui->fileComboBox->setEditText(file);
+    ui->fileComboBox->blockSignals(false);
+
+    QDialog::showEvent(event);
+    // The time window was last moved when the dialog was hidden
+    if (m_model->query().since > 0)
     {
-        case Debug:
-            item->setIcon(0, QIcon(":/icons/information-white.png"));
-            break;
-        case Warning:
-            item->setIcon(0, QIcon(":/icons/exclamation-diamond.png"));
-            break;
-        case Error:
-        case Fatal:
-            item->setIcon(0, QIcon(":/icons/exclamation-red.png"));
-            break;
+        updateSince();
+        m_sinceTimer.start();
     }
+}
+
+void ApplicationLog::hideEvent(QHideEvent* event)
+{
+    m_sinceTimer.stop();
+    QDialog::hideEvent(event);
+}
+
+void ApplicationLog::onSettingChanged(const QString& key, const QVariant& value)
+{
+    if (key == Constants::Settings::SAKURASUITE_LOG_LEVELS)
+        LogFilter::setRules(value.toString());
+}
+
+void ApplicationLog::onRowsInserted(const QModelIndex& parent, int first, int last)
+{
+    Q_UNUSED(parent);
+
+    // Grow the message column to fit the new rows instead of remeasuring every row
+    QFontMetrics metrics = ui->treeView->fontMetrics();
+    int width = m_messageWidth;
+    for (int row = qMax(first, last - MaxMeasuredRows + 1); row <= last; row++)
+        width = qMax(width, metrics.width(m_model->messageText(row)));
+
+    if (width == m_messageWidth)
+        return;
 
-    item->setText(0, message);
-    item->setText(1, m_messages.last().dateTime.toLocalTime().toString());
-    ui->treeWidget->addTopLevelItem(item);
-    ui->treeWidget->header()->resizeSections(QHeaderView::ResizeToContents);
+    m_messageWidth = width;
+    // Leave room for the level icon and the item margins
+    ui->treeView->header()->resizeSection(LogModel::MessageColumn,
+                                          m_messageWidth + style()->pixelMetric(QStyle::PM_SmallIconSize) + 24);
 }
@@ -0,0 +1,182 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+
+#include "BatchExportDialog.hpp"
+#include "ui_BatchExportDialog.h"
+#include "Metrics.hpp"
+#include <PluginInterface.hpp>
+#include <GameDocument.hpp>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QPushButton>
+
+BatchExportDialog::BatchExportDialog(QWidget* parent) :
+    QDialog(parent),
+    ui(new Ui::BatchExportDialog),
+    m_failed(0)
+{
+    ui->setupUi(this);
+
+    // Back to the event loop between exports, to repaint and see Cancel
+    m_nextTimer.setSingleShot(true);
+    m_nextTimer.setInterval(0);
+    connect(&m_nextTimer, SIGNAL(timeout()), this, SLOT(exportNext()));
+}
+
+BatchExportDialog::~BatchExportDialog()
+{
+    cancel();
+    delete ui;
+}
+
+void BatchExportDialog::setDocuments(const QList<GameDocument*>& documents)
+{
+    if (!m_queue.isEmpty())
+        return;
+
+    m_documents.clear();
+    ui->treeWidget->clear();
+    foreach (GameDocument* document, documents)
+    {
+        if (!document || !document->supportsWiiSave())
+            continue;
+
+        QTreeWidgetItem* item = new QTreeWidgetItem;
+        item->setText(DocumentColumn, QFileInfo(document->filePath()).fileName());
+        item->setToolTip(DocumentColumn, document->filePath());
+        item->setText(PluginColumn, document->loadedBy() ? document->loadedBy()->name() : QString());
+        // Unchecked documents are skipped
+        item->setCheckState(DocumentColumn, Qt::Checked);
+        ui->treeWidget->addTopLevelItem(item);
+        m_documents << document;
+    }
+
+    ui->progressBar->setValue(0);
+    ui->progressBar->setMaximum(qMax(1, m_documents.count()));
+    ui->statusLabel->setText(m_documents.isEmpty() ? tr("No open document supports WiiSaves") : QString());
+    ui->exportPushButton->setEnabled(!m_documents.isEmpty());
+}
+
+void BatchExportDialog::reject()
+{
+    if (!m_queue.isEmpty())
+    {
+        cancel();
+        return;
+    }
+
+    QDialog::reject();
+}
+
+void BatchExportDialog::onExport()
+{
+    if (!m_queue.isEmpty())
+    {
+        cancel();
+        return;
+    }
+
+    m_failed = 0;
+    for (int i = 0; i < m_documents.count(); i++)
+    {
+        QTreeWidgetItem* item = ui->treeWidget->topLevelItem(i);
+        item->setText(TimeColumn, QString());
+        if (item->checkState(DocumentColumn) != Qt::Checked || !m_documents.at(i))
+        {
+            item->setText(StatusColumn, tr("Skipped"));
+            continue;
+        }
+
+        item->setText(StatusColumn, tr("Queued"));
+        m_queue << i;
+    }
+
+    ui->progressBar->setMaximum(qMax(1, m_queue.count()));
+    ui->progressBar->setValue(0);
+    if (!m_queue.isEmpty())
+        setRunning(true);
+    scheduleNext();
+}
+
+void BatchExportDialog::exportNext()
+{
+    if (m_queue.isEmpty())
+        return;
+
+    const int index = m_queue.takeFirst();
+    GameDocument* document = m_documents.at(index);
+    QString plugin = document && document->loadedBy() ? document->loadedBy()->name() : QString();
+    QElapsedTimer elapsed;
+    elapsed.start();
+    bool exported = false;
+    if (document)
+    {
+        Metrics::Timer timer("sakurasuite_export_wiisave_seconds", plugin);
+        exported = document->exportWiiSave();
+    }
+
+    if (!exported)
+    {
+        Metrics::instance()->counter("sakurasuite_export_wiisave_failures_total", plugin)->add();
+        m_failed++;
+    }
+
+    QTreeWidgetItem* item = ui->treeWidget->topLevelItem(index);
+    item->setText(StatusColumn, exported ? tr("Exported") : tr("Failed"));
+    item->setData(TimeColumn, Qt::DisplayRole, qRound(elapsed.nsecsElapsed() / 1000000.0));
+    ui->progressBar->setValue(ui->progressBar->value() + 1);
+    scheduleNext();
+}
+
+void BatchExportDialog::scheduleNext()
+{
+    if (m_queue.isEmpty())
+    {
+        setRunning(false);
+        return;
+    }
+
+    // Shown while the export blocks the event loop
+    ui->treeWidget->topLevelItem(m_queue.first())->setText(StatusColumn, tr("Exporting"));
+    m_nextTimer.start();
+}
+
+void BatchExportDialog::cancel()
+{
+    // Only runs between exports, what was exported stays
+    m_nextTimer.stop();
+    foreach (int index, m_queue)
+    {
+        ui->treeWidget->topLevelItem(index)->setText(StatusColumn, tr("Cancelled"));
+        ui->progressBar->setValue(ui->progressBar->value() + 1);
+    }
+
+    if (!m_queue.isEmpty())
+    {
+        m_queue.clear();
+        setRunning(false);
+    }
+}
+
+void BatchExportDialog::setRunning(bool running)
+{
+    ui->treeWidget->setEnabled(!running);
+    ui->exportPushButton->setText(running ? tr("&Cancel") : tr("&Export"));
+    if (running)
+        ui->statusLabel->setText(tr("Exporting %1 WiiSaves...").arg(m_queue.count()));
+    else
+        ui->statusLabel->setText(m_failed ? tr("%1 exports failed").arg(m_failed) : tr("Export successful..."));
+}
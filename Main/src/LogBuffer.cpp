@@ -0,0 +1,131 @@
+#include "LogBuffer.hpp"
+#include <string.h>
+
+LogBuffer::LogBuffer(int capacity)
+    : m_head(0),
+      m_count(0),
+      m_appended(0)
+{
+    m_entries.resize(qMax(1, capacity));
+    m_sources.append(Source{QByteArray(), 0, QByteArray(), QString()});
+}
+
+int LogBuffer::capacity() const
+{
+    return m_entries.size();
+}
+
+int LogBuffer::count() const
+{
+    return m_count;
+}
+
+bool LogBuffer::isEmpty() const
+{
+    return m_count == 0;
+}
+
+const LogBuffer::Entry& LogBuffer::at(int i) const
+{
+    return m_entries.at((m_head + i) % m_entries.size());
+}
+
+const LogBuffer::Entry& LogBuffer::last() const
+{
+    return at(m_count - 1);
+}
+
+quint64 LogBuffer::firstSequence() const
+{
+    return m_appended - m_count;
+}
+
+int LogBuffer::indexOf(quint64 sequence) const
+{
+    quint64 first = firstSequence();
+    if (sequence < first || sequence >= m_appended)
+        return -1;
+
+    return (int)(sequence - first);
+}
+
+int LogBuffer::lowerBound(qint64 timestamp) const
+{
+    // Threads stamp their messages before queueing them, so timestamps are
+    // only roughly in order, which is close enough to find a starting point
+    int low = 0;
+    int high = m_count;
+    while (low < high)
+    {
+        int middle = low + (high - low) / 2;
+        if (at(middle).timestamp < timestamp)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    return low;
+}
+
+bool LogBuffer::append(const Entry& entry, Entry* evicted)
+{
+    const int capacity = m_entries.size();
+    m_appended++;
+    if (m_count < capacity)
+    {
+        m_entries[(m_head + m_count) % capacity] = entry;
+        m_count++;
+        return false;
+    }
+
+    // Full, the slot of the oldest entry becomes the newest
+    if (evicted)
+        *evicted = m_entries[m_head];
+    m_entries[m_head] = entry;
+    m_head = (m_head + 1) % capacity;
+    return true;
+}
+
+void LogBuffer::repeatLast(qint64 timestamp)
+{
+    Entry& entry = m_entries[(m_head + m_count - 1) % m_entries.size()];
+    entry.count++;
+    entry.lastSeen = timestamp;
+}
+
+quint32 LogBuffer::intern(const char* file, int line, const char* function)
+{
+    if (!file && !function)
+        return 0;
+
+    // Locations are looked up by address, but plugins can be unloaded and
+    // something else mapped at the same address, so verify the contents too.
+    QPair<const void*, int> key(file, line);
+    QHash<QPair<const void*, int>, quint32>::const_iterator it = m_sourceIndex.constFind(key);
+    if (it != m_sourceIndex.constEnd())
+    {
+        const Source& existing = m_sources.at(it.value());
+        if (!strcmp(existing.file.constData(), file ? file : "") &&
+            !strcmp(existing.function.constData(), function ? function : ""))
+            return it.value();
+    }
+
+    Source source = {QByteArray(file), line, QByteArray(function), QString()};
+    source.text = QString("%1(%2) %3").arg(QString::fromUtf8(source.file)).arg(line).arg(QString::fromUtf8(source.function));
+    m_sources.append(source);
+    m_sourceIndex[key] = m_sources.size() - 1;
+    return m_sources.size() - 1;
+}
+
+const LogBuffer::Source& LogBuffer::source(quint32 index) const
+{
+    return m_sources.at(index);
+}
+
+const QString& LogBuffer::location(quint32 index) const
+{
+    if (index >= (quint32)m_sources.size())
+        index = 0;
+
+    return m_sources.at(index).text;
+}
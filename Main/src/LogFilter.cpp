@@ -0,0 +1,110 @@
+#include "LogFilter.hpp"
+#include <QLoggingCategory>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QStringList>
+#include <QVector>
+#include <string.h>
+
+namespace
+{
+struct Rule
+{
+    QByteArray category;
+    bool       prefix;
+    int        minimum;
+};
+
+enum Severity
+{
+    DebugSeverity,
+    InfoSeverity,
+    WarningSeverity,
+    CriticalSeverity,
+    FatalSeverity,
+    OffSeverity
+};
+
+QMutex        rulesMutex;
+QVector<Rule> rules;
+QLoggingCategory::CategoryFilter previousFilter = NULL;
+bool          installed = false;
+
+int severity(const QString& level)
+{
+    if (level == "debug")
+        return DebugSeverity;
+    if (level == "info")
+        return InfoSeverity;
+    if (level == "warning")
+        return WarningSeverity;
+    if (level == "error" || level == "critical")
+        return CriticalSeverity;
+    if (level == "fatal")
+        return FatalSeverity;
+    if (level == "off")
+        return OffSeverity;
+    return -1;
+}
+
+void categoryFilter(QLoggingCategory* category)
+{
+    // Let QT_LOGGING_RULES and qtlogging.ini have their say first
+    if (previousFilter)
+        previousFilter(category);
+
+    QMutexLocker locker(&rulesMutex);
+    const char* name = category->categoryName();
+    int minimum = -1;
+    foreach (const Rule& rule, rules)
+    {
+        if (rule.prefix ? !strncmp(name, rule.category.constData(), rule.category.size())
+                        : !strcmp(name, rule.category.constData()))
+            minimum = rule.minimum;
+    }
+
+    if (minimum < 0)
+        return;
+
+    category->setEnabled(QtDebugMsg, minimum <= DebugSeverity);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 5, 0)
+    category->setEnabled(QtInfoMsg, minimum <= InfoSeverity);
+#endif
+    category->setEnabled(QtWarningMsg, minimum <= WarningSeverity);
+    category->setEnabled(QtCriticalMsg, minimum <= CriticalSeverity);
+}
+}
+
+void LogFilter::setRules(const QString& text)
+{
+    QVector<Rule> parsed;
+    foreach (const QString& line, text.split(QRegExp("[\n;]"), QString::SkipEmptyParts))
+    {
+        int equals = line.indexOf('=');
+        if (equals < 0)
+            continue;
+
+        QString category = line.left(equals).trimmed();
+        int minimum = severity(line.mid(equals + 1).trimmed().toLower());
+        if (category.isEmpty() || minimum < 0)
+            continue;
+
+        Rule rule = {category.toUtf8(), category.endsWith('*'), minimum};
+        if (rule.prefix)
+            rule.category.chop(1);
+        parsed << rule;
+    }
+
+    {
+        QMutexLocker locker(&rulesMutex);
+        rules = parsed;
+    }
+
+    // Installing the filter runs it over every category that already exists
+    QLoggingCategory::CategoryFilter old = QLoggingCategory::installFilter(categoryFilter);
+    if (!installed)
+    {
+        previousFilter = old;
+        installed = true;
+    }
+}
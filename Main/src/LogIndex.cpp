@@ -0,0 +1,145 @@
+#include "LogIndex.hpp"
+#include <algorithm>
+#include <iterator>
+
+namespace
+{
+// Pruned sequence numbers are only erased from the indexes once this many piled up
+const quint64 CompactInterval = 65536;
+
+void compact(QVector<quint64>& sequences, quint64 firstSequence)
+{
+    QVector<quint64>::iterator end = std::lower_bound(sequences.begin(), sequences.end(), firstSequence);
+    sequences.erase(sequences.begin(), end);
+}
+
+QVector<quint64> unite(const QVector<quint64>& a, const QVector<quint64>& b)
+{
+    QVector<quint64> result;
+    result.reserve(a.size() + b.size());
+    std::merge(a.constBegin(), a.constEnd(), b.constBegin(), b.constEnd(), std::back_inserter(result));
+    return result;
+}
+}
+
+LogIndex::Query::Query()
+    : minimumLevel(0),
+      since(0)
+{
+}
+
+bool LogIndex::Query::isEmpty() const
+{
+    return minimumLevel == 0 && file.isEmpty() && text.isEmpty() && since == 0;
+}
+
+LogIndex::LogIndex()
+    : m_firstSequence(0),
+      m_compactedAt(0)
+{
+}
+
+void LogIndex::append(quint64 sequence, quint8 level, const QByteArray& file)
+{
+    if (level < LevelCount)
+        m_byLevel[level].append(sequence);
+    if (!file.isEmpty())
+        m_byFile[file].append(sequence);
+}
+
+void LogIndex::prune(quint64 firstSequence)
+{
+    m_firstSequence = firstSequence;
+    if (m_firstSequence - m_compactedAt < CompactInterval)
+        return;
+
+    for (int i = 0; i < LevelCount; i++)
+        compact(m_byLevel[i], m_firstSequence);
+
+    QHash<QByteArray, QVector<quint64> >::iterator it = m_byFile.begin();
+    while (it != m_byFile.end())
+    {
+        compact(it.value(), m_firstSequence);
+        if (it.value().isEmpty())
+            it = m_byFile.erase(it);
+        else
+            ++it;
+    }
+
+    m_compactedAt = m_firstSequence;
+}
+
+QVector<quint64> LogIndex::match(const Query& query, const LogBuffer& buffer) const
+{
+    QVector<quint64> result;
+    const quint64 first = buffer.firstSequence();
+    const quint64 end = first + buffer.count();
+    quint64 start = first;
+    if (query.since > 0)
+        start += buffer.lowerBound(query.since);
+
+    // Start from the most selective index that applies
+    QVector<quint64> candidates;
+    bool indexed = false;
+    if (!query.file.isEmpty())
+    {
+        QHash<QByteArray, QVector<quint64> >::const_iterator it = m_byFile.constBegin();
+        for (; it != m_byFile.constEnd(); ++it)
+        {
+            if (QString::fromUtf8(it.key()).contains(query.file, Qt::CaseInsensitive))
+                candidates = unite(candidates, it.value());
+        }
+        indexed = true;
+    }
+    else if (query.minimumLevel > 0)
+    {
+        for (int level = query.minimumLevel; level < LevelCount; level++)
+            candidates = unite(candidates, m_byLevel[level]);
+        indexed = true;
+    }
+
+    if (indexed)
+    {
+        QVector<quint64>::const_iterator it = std::lower_bound(candidates.constBegin(), candidates.constEnd(), start);
+        for (; it != candidates.constEnd() && *it < end; ++it)
+        {
+            if (matches(query, buffer, buffer.at(buffer.indexOf(*it))))
+                result.append(*it);
+        }
+    }
+    else
+    {
+        for (quint64 sequence = start; sequence < end; sequence++)
+        {
+            if (matches(query, buffer, buffer.at(buffer.indexOf(sequence))))
+                result.append(sequence);
+        }
+    }
+
+    return result;
+}
+
+bool LogIndex::matches(const Query& query, const LogBuffer& buffer, const LogBuffer::Entry& entry) const
+{
+    if (entry.level < query.minimumLevel)
+        return false;
+    if (query.since > 0 && entry.timestamp < query.since)
+        return false;
+    if (!query.file.isEmpty() && !QString::fromUtf8(buffer.source(entry.source).file).contains(query.file, Qt::CaseInsensitive))
+        return false;
+    if (!query.text.isEmpty() && !entry.message.contains(query.text, Qt::CaseInsensitive))
+        return false;
+
+    return true;
+}
+
+QStringList LogIndex::files() const
+{
+    QStringList files;
+    QHash<QByteArray, QVector<quint64> >::const_iterator it = m_byFile.constBegin();
+    for (; it != m_byFile.constEnd(); ++it)
+        files << QString::fromUtf8(it.key());
+
+    files.sort();
+    return files;
+}
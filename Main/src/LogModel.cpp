@@ -0,0 +1,267 @@
+#include "LogModel.hpp"
+#include "ApplicationLog.hpp"
+#include <QDateTime>
+#include <algorithm>
+
+LogModel::LogModel(const LogBuffer* buffer, const LogIndex* index, QObject* parent)
+    : QAbstractTableModel(parent),
+      m_buffer(buffer),
+      m_index(index),
+      m_filtered(false),
+      m_firstSequence(0),
+      m_rows(0),
+      m_nextSequence(0),
+      m_lastChanged(false),
+      m_flushScheduled(false),
+      m_debugIcon(":/icons/information-white.png"),
+      m_warningIcon(":/icons/exclamation-diamond.png"),
+      m_errorIcon(":/icons/exclamation-red.png")
+{
+}
+
+void LogModel::entryAppended()
+{
+    scheduleFlush();
+}
+
+void LogModel::entryRepeated()
+{
+    m_lastChanged = true;
+    scheduleFlush();
+}
+
+void LogModel::scheduleFlush()
+{
+    if (m_flushScheduled)
+        return;
+
+    m_flushScheduled = true;
+    QMetaObject::invokeMethod(this, "flush", Qt::QueuedConnection);
+}
+
+void LogModel::setQuery(const LogIndex::Query& query)
+{
+    beginResetModel();
+    m_query = query;
+    m_filtered = !query.isEmpty();
+    m_firstSequence = m_buffer->firstSequence();
+    m_nextSequence = m_firstSequence + m_buffer->count();
+    if (m_filtered)
+    {
+        m_matches = m_index->match(m_query, *m_buffer);
+        m_rows = m_matches.size();
+    }
+    else
+    {
+        m_matches.clear();
+        m_rows = m_buffer->count();
+    }
+    endResetModel();
+}
+
+const LogIndex::Query& LogModel::query() const
+{
+    return m_query;
+}
+
+void LogModel::setSince(qint64 since)
+{
+    if (since == m_query.since)
+        return;
+
+    if (!m_filtered || since < m_query.since || m_query.since == 0)
+    {
+        LogIndex::Query query = m_query;
+        query.since = since;
+        setQuery(query);
+        return;
+    }
+
+    // Timestamps are only roughly in order, stopping at the first recent enough row is close enough
+    m_query.since = since;
+    int removed = 0;
+    while (removed < m_rows)
+    {
+        const LogBuffer::Entry* entry = this->entry(removed);
+        if (entry && entry->timestamp >= since)
+            break;
+        removed++;
+    }
+
+    if (removed == 0)
+        return;
+
+    beginRemoveRows(QModelIndex(), 0, removed - 1);
+    m_matches.remove(0, removed);
+    m_rows -= removed;
+    endRemoveRows();
+}
+
+void LogModel::flush()
+{
+    m_flushScheduled = false;
+    bool lastChanged = m_lastChanged;
+    m_lastChanged = false;
+
+    const quint64 first = m_buffer->firstSequence();
+    const quint64 end = first + m_buffer->count();
+
+    // The buffer evicts from the front, the oldest rows go first
+    int removed = 0;
+    if (m_filtered)
+        removed = std::lower_bound(m_matches.constBegin(), m_matches.constEnd(), first) - m_matches.constBegin();
+    else if (first > m_firstSequence)
+        removed = (int)qMin<quint64>(first - m_firstSequence, m_rows);
+
+    if (removed > 0 && removed == m_rows)
+    {
+        // Everything the view knows about is gone, starting over is cheaper
+        setQuery(m_query);
+        return;
+    }
+
+    if (removed > 0)
+    {
+        beginRemoveRows(QModelIndex(), 0, removed - 1);
+        if (m_filtered)
+            m_matches.remove(0, removed);
+        m_firstSequence += removed;
+        m_rows -= removed;
+        endRemoveRows();
+    }
+
+    // The repeated entry is always the newest one, if it was just inserted there's nothing to update
+    if (lastChanged && m_rows > 0 && m_nextSequence == end && sequence(m_rows - 1) == end - 1)
+        emit dataChanged(index(m_rows - 1, 0), index(m_rows - 1, ColumnCount - 1));
+
+    const quint64 start = qMax(m_nextSequence, first);
+    m_nextSequence = end;
+    if (start >= end)
+        return;
+
+    if (!m_filtered)
+    {
+        if (m_rows == 0)
+            m_firstSequence = start;
+        beginInsertRows(QModelIndex(), m_rows, m_rows + (int)(end - start) - 1);
+        m_rows += (int)(end - start);
+        endInsertRows();
+        return;
+    }
+
+    // Only the new entries need checking against the query
+    QVector<quint64> matches;
+    for (quint64 sequence = start; sequence < end; sequence++)
+    {
+        if (m_index->matches(m_query, *m_buffer, m_buffer->at(m_buffer->indexOf(sequence))))
+            matches.append(sequence);
+    }
+
+    if (matches.isEmpty())
+        return;
+
+    beginInsertRows(QModelIndex(), m_rows, m_rows + matches.size() - 1);
+    m_matches += matches;
+    m_rows = m_matches.size();
+    endInsertRows();
+}
+
+quint64 LogModel::sequence(int row) const
+{
+    return m_filtered ? m_matches.at(row) : m_firstSequence + row;
+}
+
+const LogBuffer::Entry* LogModel::entry(int row) const
+{
+    if (row < 0 || row >= m_rows)
+        return NULL;
+
+    int i = m_buffer->indexOf(sequence(row));
+    return i < 0 ? NULL : &m_buffer->at(i);
+}
+
+int LogModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : m_rows;
+}
+
+int LogModel::columnCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant LogModel::data(const QModelIndex& index, int role) const
+{
+    const LogBuffer::Entry* entry = this->entry(index.row());
+    if (!index.isValid() || !entry)
+        return QVariant();
+
+    if (role == Qt::DisplayRole)
+    {
+        if (index.column() == MessageColumn)
+            return messageText(index.row());
+        if (index.column() == DateTimeColumn)
+            return dateTimeText(index.row());
+    }
+    else if (role == Qt::ToolTipRole)
+    {
+        if (entry->count > 1)
+            return tr("Repeated %1 times, last at %2").arg(entry->count)
+                    .arg(QDateTime::fromMSecsSinceEpoch(entry->lastSeen).toLocalTime().toString());
+    }
+    else if (role == Qt::DecorationRole && index.column() == MessageColumn)
+    {
+        switch (entry->level)
+        {
+            case ApplicationLog::Debug:
+                return m_debugIcon;
+            case ApplicationLog::Warning:
+                return m_warningIcon;
+            case ApplicationLog::Error:
+            case ApplicationLog::Fatal:
+                return m_errorIcon;
+        }
+    }
+
+    return QVariant();
+}
+
+QVariant LogModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+        return QVariant();
+
+    switch (section)
+    {
+        case MessageColumn:
+            return tr("Message");
+        case DateTimeColumn:
+            return tr("DateTime");
+    }
+
+    return QVariant();
+}
+
+QString LogModel::messageText(int row) const
+{
+    const LogBuffer::Entry* entry = this->entry(row);
+    if (!entry)
+        return QString();
+
+    QString text = entry->message;
+    if (entry->source != 0)
+        text = QString("[%1]: %2").arg(m_buffer->location(entry->source)).arg(text);
+    if (entry->count > 1)
+        text += QString(" (x%1)").arg(entry->count);
+
+    return text;
+}
+
+QString LogModel::dateTimeText(int row) const
+{
+    const LogBuffer::Entry* entry = this->entry(row);
+    if (!entry)
+        return QString();
+
+    return QDateTime::fromMSecsSinceEpoch(entry->timestamp).toLocalTime().toString();
+}
@@ -0,0 +1,138 @@
+#include "LogQueue.hpp"
+
+namespace
+{
+// Released nodes, producers only ever take the whole list at once,
+// which keeps the pushes safe from ABA without a counter
+struct FreeNodes
+{
+    ~FreeNodes()
+    {
+        LogQueue::Node* node = nodes.load();
+        while (node)
+        {
+            LogQueue::Node* next = node->next.load();
+            delete node;
+            node = next;
+        }
+    }
+
+    void push(LogQueue::Node* first, LogQueue::Node* last)
+    {
+        LogQueue::Node* head;
+        do
+        {
+            head = nodes.load();
+            last->next.store(head);
+        } while (!nodes.testAndSetRelease(head, first));
+    }
+
+    QAtomicPointer<LogQueue::Node> nodes;
+};
+
+FreeNodes freeNodes;
+
+struct NodeCache
+{
+    NodeCache() : nodes(NULL) {}
+
+    // The thread is exiting, hand its nodes to the threads still logging
+    ~NodeCache()
+    {
+        if (!nodes)
+            return;
+
+        LogQueue::Node* last = nodes;
+        while (LogQueue::Node* next = last->next.load())
+            last = next;
+        freeNodes.push(nodes, last);
+    }
+
+    LogQueue::Node* nodes;
+};
+
+thread_local NodeCache nodeCache;
+}
+
+LogQueue::LogQueue()
+    : m_head(&m_stub),
+      m_tail(&m_stub)
+{
+    m_stub.next.store(NULL);
+}
+
+LogQueue::~LogQueue()
+{
+    while (Node* node = pop())
+        release(node);
+}
+
+LogQueue::Node* LogQueue::allocate()
+{
+    NodeCache& cache = nodeCache;
+    if (!cache.nodes)
+        cache.nodes = freeNodes.nodes.fetchAndStoreAcquire(NULL);
+    if (!cache.nodes)
+        return new Node;
+
+    Node* node = cache.nodes;
+    cache.nodes = node->next.load();
+    return node;
+}
+
+void LogQueue::release(Node* node)
+{
+    // Free the message on the consumer's thread, not on the next producer's
+    node->message = QString();
+    freeNodes.push(node, node);
+}
+
+void LogQueue::push(Node* node)
+{
+    node->next.store(NULL);
+    Node* prev = m_head.fetchAndStoreOrdered(node);
+    // Between the exchange and this store the queue is briefly unlinked,
+    // the consumer treats that as empty and comes back later
+    prev->next.storeRelease(node);
+}
+
+LogQueue::Node* LogQueue::pop()
+{
+    Node* tail = m_tail;
+    Node* next = tail->next.loadAcquire();
+
+    if (tail == &m_stub)
+    {
+        if (!next)
+            return NULL;
+
+        m_tail = next;
+        tail = next;
+        next = next->next.loadAcquire();
+    }
+
+    if (next)
+    {
+        m_tail = next;
+        return tail;
+    }
+
+    if (tail != m_head.loadAcquire())
+        return NULL;
+
+    // tail is the last node, put the stub back behind it so it can be taken
+    push(&m_stub);
+    next = tail->next.loadAcquire();
+    if (next)
+    {
+        m_tail = next;
+        return tail;
+    }
+
+    return NULL;
+}
+
+bool LogQueue::isEmpty() const
+{
+    return m_tail == &m_stub && m_head.loadAcquire() == &m_stub;
+}
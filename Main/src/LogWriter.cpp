@@ -0,0 +1,139 @@
+#include "LogWriter.hpp"
+#include "ApplicationLog.hpp"
+#include "AllocationProfiler.hpp"
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+
+namespace
+{
+const qint64 MaxFileSize = 4 * 1024 * 1024;
+const int    MaxRotated  = 5;
+// If the disk can't keep up, drop text rather than grow without bounds
+const int    MaxPending  = 100000;
+// flush() gives up after this long, it's used on the way to an abort
+const int    FlushTimeout = 2000;
+}
+
+LogWriter::LogWriter(const QString& fileName, QObject* parent)
+    : QThread(parent),
+      m_fileName(fileName),
+      m_dropped(0),
+      m_writing(false),
+      m_stop(false)
+{
+}
+
+LogWriter::~LogWriter()
+{
+    stop();
+    wait();
+}
+
+void LogWriter::write(const QVector<Record>& records)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_records.size() + records.size() > MaxPending)
+    {
+        m_dropped += records.size();
+        return;
+    }
+
+    if (m_records.isEmpty())
+        m_records = records;
+    else
+        m_records += records;
+    m_pending.wakeOne();
+}
+
+void LogWriter::flush()
+{
+    QMutexLocker locker(&m_mutex);
+    while ((!m_records.isEmpty() || m_writing) && isRunning())
+    {
+        if (!m_written.wait(&m_mutex, FlushTimeout))
+            break;
+    }
+}
+
+void LogWriter::stop()
+{
+    QMutexLocker locker(&m_mutex);
+    m_stop = true;
+    m_pending.wakeOne();
+}
+
+void LogWriter::run()
+{
+    AllocationProfiler::Scope allocations("log");
+    if (!open())
+        return;
+
+    // A log left over from the last run explains what happened then, keep it around
+    if (m_file.size() > 0)
+        rotate();
+
+    forever
+    {
+        QVector<Record> records;
+        qint64 dropped = 0;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (m_records.isEmpty() && !m_stop)
+                m_pending.wait(&m_mutex);
+
+            if (m_records.isEmpty() && m_stop)
+                break;
+
+            records.swap(m_records);
+            qSwap(dropped, m_dropped);
+            m_writing = true;
+        }
+
+        // Writing to a closed file would warn, which would be logged and end up here again
+        if (m_file.isOpen())
+        {
+            if (dropped > 0)
+                m_file.write(QString("[Warning]: %1 messages dropped, the log file couldn't keep up\n").arg(dropped).toUtf8());
+
+            QByteArray data;
+            foreach (const Record& record, records)
+            {
+                data += ApplicationLog::formatEntry(record.timestamp, record.level, record.location, record.message).toUtf8();
+                data += '\n';
+            }
+            m_file.write(data);
+            // Hand it to the OS right away, a crash can't lose it after this
+            m_file.flush();
+
+            if (m_file.size() >= MaxFileSize)
+                rotate();
+        }
+
+        QMutexLocker locker(&m_mutex);
+        m_writing = false;
+        m_written.wakeAll();
+    }
+
+    m_file.close();
+}
+
+bool LogWriter::open()
+{
+    QDir().mkpath(QFileInfo(m_fileName).absolutePath());
+    m_file.setFileName(m_fileName);
+    return m_file.open(QFile::WriteOnly | QFile::Append);
+}
+
+void LogWriter::rotate()
+{
+    m_file.close();
+
+    // Renamed rather than compressed, so any tool can read them and nothing is read into memory
+    QFile::remove(QString("%1.%2").arg(m_fileName).arg(MaxRotated));
+    for (int i = MaxRotated - 1; i > 0; i--)
+        QFile::rename(QString("%1.%2").arg(m_fileName).arg(i), QString("%1.%2").arg(m_fileName).arg(i + 1));
+    QFile::rename(m_fileName, QString("%1.1").arg(m_fileName));
+
+    m_file.open(QFile::WriteOnly | QFile::Truncate);
+}
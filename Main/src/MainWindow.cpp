@@ -20,6 +20,17 @@
 #include "PreferencesDialog.hpp"
 #include "WiiKeyManager.hpp"
 #include "ApplicationLog.hpp"
+#include "SearchDock.hpp"
+#include "SettingsStore.hpp"
+#include "PageCacheWarmer.hpp"
+#include "PerformanceDialog.hpp"
+#include "BatchExportDialog.hpp"
+#include "Tracer.hpp"
+#include "SessionRecorder.hpp"
+#include "StartupProfile.hpp"
+#include "Metrics.hpp"
+#include "PluginUsage.hpp"
+#include "AllocationProfiler.hpp"
 // Updater Includes
 #include <Updater.hpp>
 
@@ -44,6 +55,11 @@ MainWindow::MainWindow(QWidget *parent) :
     ui(new Ui::MainWindow),
     m_currentFile(NULL),
     m_applicationLog(ApplicationLog::instance()),
+    m_performanceDialog(NULL),
+    m_batchExportDialog(NULL),
+    m_settings(SettingsStore::instance()),
+    m_searchDock(NULL),
+    m_pageCacheWarmer(NULL),
     m_pluginsManager(new PluginsManager(this)),
     m_aboutDialog(NULL),
     m_updater(new Updater(this)),
@@ -51,8 +67,7 @@ MainWindow::MainWindow(QWidget *parent) :
     m_updateMBox(this),
     m_cancelClose(false),
     m_keyManager(new WiiKeyManager(this)),
-    m_untitledDocs(0),
-    m_haveLock(false)
+    m_untitledDocs(0)
   #ifdef WK2_PREVIEW
   ,m_previewLayout(NULL),
     m_previewLabel(NULL)
@@ -60,34 +75,29 @@ MainWindow::MainWindow(QWidget *parent) :
 {
     ui->setupUi(this);
     qDebug() << "MainWindow initialized";
+    // Plugins query the engine paths constantly, so keep them cached
+    m_engineDataPath = QDir(m_settings->value<QString>(Constants::Settings::SAKURASUITE_ENGINE_DATA_PATH));
+    m_engineExecutable = m_settings->value<QUrl>(Constants::Settings::SAKURASUITE_ENGINE_EXECUTABLE);
+    connect(m_settings, SIGNAL(valueChanged(QString,QVariant)), this, SLOT(onSettingChanged(QString,QVariant)));
     m_applicationLog->setParent(this, Qt::Dialog);
     connect(ui->actionLog, SIGNAL(triggered()), m_applicationLog, SLOT(exec()));
-
-#ifndef SS_DEBUG
-    qDebug() << "Checking for lock";
-    // lock Application
-    if (checkLock())
-    {
-        qCritical() << "Couldn't obtain lock";
-        qApp->quit();
-        return;
-    }
-#endif
+    m_performanceDialog = new PerformanceDialog(this);
+    connect(ui->actionPerformance, SIGNAL(triggered()), m_performanceDialog, SLOT(exec()));
+    m_batchExportDialog = new BatchExportDialog(this);
+    // Plugins built against an older MainWindowBase find the tracer through TraceInterface::find
+    setProperty("tracer", QVariant::fromValue<QObject*>(Tracer::instance()));
 
     // lets load the plugins
     m_pluginsManager->loadPlugins();
 
+    // SAKURASUITE_RECORD_SESSION=<file> records a script for sakurasuite_replay
+    QString sessionScript = QString::fromLocal8Bit(qgetenv("SAKURASUITE_RECORD_SESSION"));
+    if (!sessionScript.isEmpty())
+        SessionRecorder::instance()->start(sessionScript, m_settings->value<QString>(Constants::Settings::SAKURASUITE_ENGINE_DATA_PATH));
+
     m_preferencesDialog = new PreferencesDialog(m_keyManager, this);
-    connect(&m_lockTimer, SIGNAL(timeout()), SLOT(onLockTimeout()));
 
     loadWiiKeys();
-    // we set the timer to timeout every 58 seconds
-    // Since checkLock expects a stale cookie to be over 60 seconds old
-    // this ensures that there is never a race condition
-    // Since it's nearly impossible two instances to overlap
-    // such a time span (unless you get some REALLY bad lag, again, not likely)
-    m_lockTimer.setInterval(58*1000);
-    m_lockTimer.start();
 
     // Center window
     resize(QSize(std::min(700, QApplication::desktop()->width() / 2), QApplication::desktop()->height() / 2));
@@ -96,6 +106,12 @@ MainWindow::MainWindow(QWidget *parent) :
     m_defaultWindowGeometry = this->saveGeometry();
     m_defaultWindowState = this->saveState();
 
+    // Setup the "Find in Data" dock, it stays hidden until requested
+    m_searchDock = new SearchDock(this);
+    addDockWidget(Qt::BottomDockWidgetArea, m_searchDock);
+    m_searchDock->hide();
+    connect(m_searchDock, SIGNAL(openRequested(QString)), this, SLOT(onOpenSearchResult(QString)));
+
     // Setup "Styles" menu
     setupStyleActions();
 
@@ -128,18 +144,12 @@ MainWindow::MainWindow(QWidget *parent) :
     // Hide the toolbar if it has no actions
     ui->mainToolBar->setVisible((ui->mainToolBar->actions().count() > 0));
 
-    QSettings settings;
-    if (settings.value(Constants::Settings::SAKURASUITE_CHECK_ON_START, false).toBool())
+    if (m_settings->value<bool>(Constants::Settings::SAKURASUITE_CHECK_ON_START, false))
         onCheckUpdate();
 }
 
 MainWindow::~MainWindow()
 {
-    if (m_haveLock)
-        // We were able to acquire the lock, we need to remove it.
-        QFile(Constants::SAKURASUITE_LOCK_FILE).remove();
-
-
 #if defined(SS_PREVIEW) || defined(SS_INTERNAL)
     if (m_previewLayout)
     {
@@ -154,9 +164,8 @@ MainWindow::~MainWindow()
     }
 #endif
 
-    QSettings settings;
-    settings.setValue("mainWindowGeometry", saveGeometry());
-    settings.setValue("mainWindowState", saveState());
+    m_settings->setValue("mainWindowGeometry", saveGeometry());
+    m_settings->setValue("mainWindowState", saveState());
 
 
     foreach (DocumentBase* file, m_documents.values())
@@ -186,9 +195,8 @@ void MainWindow::initUpdater()
 
 void MainWindow::restoreDefaultGeometry()
 {
-    QSettings settings;
-    restoreGeometry(settings.value("mainWindowGeometry").toByteArray());
-    restoreState(settings.value("mainWindowState").toByteArray());
+    restoreGeometry(m_settings->value<QByteArray>("mainWindowGeometry"));
+    restoreState(m_settings->value<QByteArray>("mainWindowState"));
 }
 
 void MainWindow::injectPreviewLabel()
@@ -298,8 +306,30 @@ void MainWindow::closeFilesFromLoader(PluginInterface* loader)
     targets.clear();
 }
 
+DocumentBase* MainWindow::document(const QString& file)
+{
+    return m_documents.value(cleanPath(file), NULL);
+}
+
+bool MainWindow::activateDocument(const QString& file)
+{
+    QString filePath = cleanPath(file);
+    for (int i = 0; i < ui->documentList->count(); i++)
+    {
+        QListWidgetItem* item = ui->documentList->item(i);
+        if (cleanPath(item->data(FILEPATH).toString()) == filePath)
+        {
+            ui->documentList->setCurrentItem(item);
+            return true;
+        }
+    }
+
+    return false;
+}
+
 QString MainWindow::cleanPath(const QString& currentFile)
 {
+    AllocationProfiler::Scope allocations("cleanPath");
     QString filePath = currentFile;
     filePath = filePath.replace("\\", "/");
 #ifdef Q_OS_WIN
@@ -377,14 +407,19 @@ PluginsManager* MainWindow::pluginsManager() const
     return m_pluginsManager;
 }
 
+TraceInterface* MainWindow::tracer() const
+{
+    return Tracer::instance();
+}
+
 QDir MainWindow::engineDataPath() const
 {
-    return QDir(QSettings().value(Constants::Settings::SAKURASUITE_ENGINE_DATA_PATH).toString());
+    return m_engineDataPath;
 }
 
 QUrl MainWindow::engineExecutable() const
 {
-    return QSettings().value(Constants::Settings::SAKURASUITE_ENGINE_EXECUTABLE).toUrl();
+    return m_engineExecutable;
 }
 
 QDir MainWindow::homePath() const
@@ -423,12 +458,17 @@ void MainWindow::onNewDocument(DocumentBase* document)
 
 void MainWindow::closeEvent(QCloseEvent* e)
 {
+    QStringList session = sessionFiles();
     onCloseAll();
 
     if (m_cancelClose)
+    {
         e->ignore();
-    else
-        e->accept();
+        return;
+    }
+
+    saveSession(session);
+    e->accept();
 }
 
 void MainWindow::dragEnterEvent(QDragEnterEvent* e)
@@ -465,6 +505,11 @@ void MainWindow::loadWiiKeys()
                 qWarning() << "Unable to load keys";
         }
     }
+
+    // Dumps of other consoles to switch to in the preferences
+    QString keysPath = Constants::SAKURASUITE_HOME_PATH + QDir::separator() + "keys";
+    if (QDir(keysPath).exists())
+        m_keyManager->openDirectory(keysPath);
 }
 
 void MainWindow::openFile(const QString& currentFile)
@@ -482,19 +527,28 @@ void MainWindow::openFile(const QString& currentFile)
         return;
     }
 
+    PageCacheWarmer::ForegroundIo foregroundIo;
+    Metrics::Timer timer("sakurasuite_open_seconds");
     PluginInterface* loader = m_pluginsManager->preferredPlugin(filePath);
     if (!loader)
     {
+        timer.finish();
+        Metrics::instance()->counter("sakurasuite_open_failures_total")->add();
         msgBox.setWindowTitle("Unable to find suitable loader...");
         msgBox.setText(tr("%1 was unable to determine an appropriate plugin to load '%2' with.").arg(Constants::SAKURASUITE_TITLE).arg(filePath));
         msgBox.exec();
         return;
     }
 
+    timer.setPlugin(loader->name());
+    PluginUsage::Scope usage(loader);
     DocumentBase* file = loader->loadFile(filePath);
+    usage.finish();
 
     if (!file)
     {
+        timer.finish();
+        Metrics::instance()->counter("sakurasuite_open_failures_total", loader->name())->add();
         msgBox.setWindowTitle(Constants::SAKURASUITE_OPEN_FAILED);
         msgBox.setText(Constants::SAKURASUITE_OPEN_FAILED_MSG.arg(strippedName(filePath)).arg(loader->name()));
         msgBox.setStandardButtons(QMessageBox::Ok);
@@ -503,6 +557,8 @@ void MainWindow::openFile(const QString& currentFile)
         return;
     }
     connect(file, SIGNAL(modified()), this, SLOT(updateWindowTitle()));
+    SessionRecorder::instance()->record("open", filePath);
+    SessionRecorder::instance()->watch(file);
     m_documents[filePath] = file;
     m_fileSystemWatcher.addPath(filePath);
 
@@ -527,9 +583,10 @@ void MainWindow::openFile(const QString& currentFile)
     ui->documentList->setCurrentItem(item);
     m_currentFile = file;
     updateMRU(filePath);
-    QSettings settings;
-    settings.setValue(Constants::Settings::SAKURASUITE_RECENT_DIRECTORY, cleanPath(QFileInfo(filePath).absolutePath()));
+    m_settings->setValue(Constants::Settings::SAKURASUITE_RECENT_DIRECTORY, cleanPath(QFileInfo(filePath).absolutePath()));
     updateWindowTitle();
+    Metrics::instance()->gauge("sakurasuite_open_documents")->set(m_documents.count());
+    Tracer::instance()->counter("sakurasuite_open_documents", m_documents.count());
 }
 
 void MainWindow::onDocumentChanged(int row)
@@ -554,11 +611,14 @@ void MainWindow::onDocumentChanged(int row)
     // First we need to store the old Widget so we can remove
     // it from the main layout.
     DocumentBase* oldFile = m_currentFile;
-    m_currentFile = m_documents[cleanPath(ui->documentList->currentItem()->data(FILEPATH).toString())];
+    QString currentPath = cleanPath(ui->documentList->currentItem()->data(FILEPATH).toString());
+    m_currentFile = m_documents[currentPath];
 
     if (!m_currentFile)
         return;
 
+    SessionRecorder::instance()->record("switch", currentPath);
+
     GameDocument* gd = dynamic_cast<GameDocument*>(m_currentFile);
     ui->actionExportWiiSave->setEnabled((gd && gd->supportsWiiSave()));
 
@@ -603,6 +663,7 @@ void MainWindow::onClose()
     }
 
     QString filePath = cleanPath(ui->documentList->currentItem()->data(FILEPATH).toString());
+    SessionRecorder::instance()->record("close", filePath);
     m_fileSystemWatcher.removePath(cleanPath(filePath));
     m_documents.remove(cleanPath(filePath));
     delete m_currentFile;
@@ -613,6 +674,8 @@ void MainWindow::onClose()
         this->setWindowTitle(Constants::SAKURASUITE_TITLE);
 
     ui->actionReload->setEnabled(ui->documentList->count() > 0);
+    Metrics::instance()->gauge("sakurasuite_open_documents")->set(m_documents.count());
+    Tracer::instance()->counter("sakurasuite_open_documents", m_documents.count());
 }
 
 void MainWindow::onCloseAll()
@@ -643,6 +706,8 @@ void MainWindow::onSave()
     if (!m_currentFile->fileName().isEmpty())
         m_fileSystemWatcher.removePath(cleanPath(m_currentFile->filePath()));
 
+    PageCacheWarmer::ForegroundIo foregroundIo;
+
 
     GameDocument* gd = dynamic_cast<GameDocument*>(m_currentFile);
 
@@ -652,10 +717,22 @@ void MainWindow::onSave()
         return;
     }
 
-    if (m_currentFile->save())
+    Metrics::Timer timer("sakurasuite_save_seconds", pluginName(m_currentFile));
+    PluginUsage::Scope usage(m_currentFile->loadedBy());
+    bool saved = m_currentFile->save();
+    usage.finish();
+    timer.finish();
+
+    if (saved)
+    {
+        SessionRecorder::instance()->record("save", cleanPath(m_currentFile->filePath()));
         statusBar()->showMessage(tr("Save successful"), 2000);
+    }
     else
+    {
+        Metrics::instance()->counter("sakurasuite_save_failures_total", pluginName(m_currentFile))->add();
         statusBar()->showMessage(tr("Save failed"), 2000);
+    }
 
     m_fileSystemWatcher.addPath(cleanPath(m_currentFile->filePath()));
     updateWindowTitle();
@@ -673,11 +750,23 @@ void MainWindow::onSaveAs()
     if (file.isEmpty())
         return;
 
-    file = cleanPath(file);
+    saveCurrentAs(file);
+}
+
+bool MainWindow::saveCurrentAs(const QString& fileName)
+{
+    if (!m_currentFile)
+        return false;
+
+    QString file = cleanPath(fileName);
+    PageCacheWarmer::ForegroundIo foregroundIo;
     QListWidgetItem* item = ui->documentList->currentItem();
     QString currentPath = cleanPath(item->data(FILEPATH).toString());
     bool success = false;
+    bool renamed = false;
 
+    Metrics::Timer timer("sakurasuite_save_seconds", pluginName(m_currentFile));
+    PluginUsage::Scope usage(m_currentFile->loadedBy());
     if (currentPath != file && m_currentFile->save(file))
     {
         m_documents.remove(currentPath);
@@ -688,26 +777,42 @@ void MainWindow::onSaveAs()
         item->setText(item->data(FILENAME).toString());
         updateMRU(file);
         success = true;
+        renamed = true;
     }
     else if (m_currentFile->save())
     {
         success = true;
     }
+    usage.finish();
+    timer.finish();
 
     if (success)
+    {
+        // Later actions refer to the document by its new path
+        if (renamed)
+            SessionRecorder::instance()->record("saveAs", currentPath, file);
+        else
+            SessionRecorder::instance()->record("save", currentPath);
         statusBar()->showMessage(tr("Save successful"), 2000);
+    }
     else
+    {
+        Metrics::instance()->counter("sakurasuite_save_failures_total", pluginName(m_currentFile))->add();
         statusBar()->showMessage(tr("Save failed"), 2000);
+    }
     updateWindowTitle();
+    return success;
 }
 
 void MainWindow::onExit()
 {
+    QStringList session = sessionFiles();
     onCloseAll();
 
     if (m_cancelClose)
         return;
 
+    saveSession(session);
     qApp->quit();
 }
 
@@ -726,15 +831,14 @@ void MainWindow::onAboutQt()
 
 void MainWindow::updateMRU(const QString& file)
 {
-    QSettings settings;
-    QStringList files = settings.value(Constants::Settings::SAKURASUITE_RECENT_FILES).toStringList();
+    QStringList files = m_settings->value<QStringList>(Constants::Settings::SAKURASUITE_RECENT_FILES);
     files.removeAll(cleanPath(file));
     files.prepend(cleanPath(file));
 
     while (files.size() > MAXRECENT)
         files.removeLast();
 
-    settings.setValue(Constants::Settings::SAKURASUITE_RECENT_FILES, files);
+    m_settings->setValue(Constants::Settings::SAKURASUITE_RECENT_FILES, files);
     updateRecentFileActions();
 
     foreach (QWidget* widget, QApplication::topLevelWidgets())
@@ -747,8 +851,7 @@ void MainWindow::updateMRU(const QString& file)
 
 void MainWindow::updateRecentFileActions()
 {
-    QSettings settings;
-    QStringList files = settings.value(Constants::Settings::SAKURASUITE_RECENT_FILES).toStringList();
+    QStringList files = m_settings->value<QStringList>(Constants::Settings::SAKURASUITE_RECENT_FILES);
 
     int numRecentFiles = qMin(files.size(), (int)MAXRECENT);
 
@@ -769,18 +872,18 @@ void MainWindow::updateRecentFileActions()
 
 void MainWindow::setupStyleActions()
 {
-    if (!QSettings().value(Constants::Settings::SAKURASUITE_DEFAULT_STYLE).isValid())
+    if (!m_settings->contains(Constants::Settings::SAKURASUITE_DEFAULT_STYLE))
     {
         if(qApp->style())
-            QSettings().setValue(Constants::Settings::SAKURASUITE_DEFAULT_STYLE, qApp->style()->objectName());
+            m_settings->setValue(Constants::Settings::SAKURASUITE_DEFAULT_STYLE, qApp->style()->objectName());
         else
-            QSettings().setValue(Constants::Settings::SAKURASUITE_DEFAULT_STYLE, qApp->desktop()->style()->objectName());
+            m_settings->setValue(Constants::Settings::SAKURASUITE_DEFAULT_STYLE, qApp->desktop()->style()->objectName());
     }
     QStringList styles = QStyleFactory::keys();
     QActionGroup* actionGroup = new QActionGroup(this);
     actionGroup->addAction(ui->actionDefaultStyle);
 
-    QString currentStyle = QSettings().value(Constants::Settings::SAKURASUITE_CURRENT_STYLE).toString();
+    QString currentStyle = m_settings->value<QString>(Constants::Settings::SAKURASUITE_CURRENT_STYLE);
     qApp->setStyle(currentStyle);
 
     foreach (QString style, styles)
@@ -796,6 +899,23 @@ void MainWindow::setupStyleActions()
     }
 }
 
+void MainWindow::openFiles(const QStringList& files)
+{
+    foreach (const QString& file, files)
+    {
+        if (!m_documents.contains(cleanPath(file)))
+            openFile(file);
+    }
+
+    // Files forwarded from another instance should bring us to the front
+    if (!files.isEmpty())
+    {
+        setWindowState(windowState() & ~Qt::WindowMinimized);
+        raise();
+        activateWindow();
+    }
+}
+
 void MainWindow::openRecentFile()
 {
     QAction* action = qobject_cast<QAction*>(sender());
@@ -868,24 +988,12 @@ void MainWindow::onNoUpdate()
     m_updateMBox.hide();
 }
 
-void MainWindow::onLockTimeout()
-{
-    if (QSettings().value("singleInstance", false).toBool())
-    {
-        QFile file(Constants::SAKURASUITE_LOCK_FILE);
-        if (file.open(QFile::WriteOnly))
-        {
-            file.seek(0);
-            file.write(QString(QDateTime::currentDateTime().toString() + "\n").toLatin1());
-            file.resize(file.pos());
-        }
-    }
-}
-
 void MainWindow::showEvent(QShowEvent* se)
 {
+    StartupProfile::instance()->mark("showEvent");
 #ifndef SS_DEBUG
-    if (m_pluginsManager->plugins().count() <= 0)
+    // Nobody is there to dismiss the message while startup is profiled
+    if (m_pluginsManager->plugins().count() <= 0 && !StartupProfile::instance()->isEnabled())
     {
         QMessageBox mbox;
         mbox.setWindowTitle(Constants::SAKURASUITE_NO_PLUGINS_ERROR);
@@ -898,63 +1006,40 @@ void MainWindow::showEvent(QShowEvent* se)
 #endif
 
     QMainWindow::showEvent(se);
-}
-
-// Checklock returns true if lock exists
 
+    // Once the window is up, prefetch what the user is likely to open next
+    if (!m_pageCacheWarmer)
+        warmPageCache();
+}
 
-bool MainWindow::checkLock()
+void MainWindow::warmPageCache()
 {
-    // The lock file is pretty simple
-    // All the application does is output the current time
-    // of course if a malicious program decided to be a jerk
-    // it could output a date several years in the future
-    // But since we're using the temp directory
-    // theoretically the file should be deleted after every boot
-    // But some OSes don't abide by this (Windows I'm looking at you)
-    // So we should probably check that too but for now this'll do
-    // I COULD use some Qt magic and have it output the lock file, but
-    // that's neither here nor there, plus this is simple enough for our purposes
-    if (QFile::exists(Constants::SAKURASUITE_LOCK_FILE) && QSettings().value("singleInstance", false).toBool())
+    QStringList files = m_settings->value<QStringList>(Constants::Settings::SAKURASUITE_RECENT_FILES).mid(0, MAXWARM);
+    foreach (const QString& file, m_settings->value<QStringList>(Constants::Settings::SAKURASUITE_SESSION_FILES))
     {
-        QFile file(Constants::SAKURASUITE_LOCK_FILE);
-        if (file.open(QFile::ReadOnly))
-        {
-            QDateTime time = QDateTime::fromString(QString(file.readLine()));
-            quint64 msecs = time.msecsTo(QDateTime::currentDateTime());
-            if (msecs > (60*1000))
-            {
-                // We have a stale lock, which means the old
-                // instance either crashed, or didn't have a chance
-                // to clean up after itself, we can safely ignore it.
-                qDebug() << "Found stale lock, ignoring";
-                createLock();
-                return false;
-            }
-        }
-        QMessageBox mbox(this);
-        mbox.setWindowTitle(Constants::SAKURASUITE_INSTANCE_EXISTS);
-        mbox.setText(Constants::SAKURASUITE_INSTANCE_EXISTS_MSG);
-        mbox.exec();
-        return true;
+        if (!files.contains(file))
+            files << file;
     }
-    else if (QSettings().value("singleInstance", false).toBool())
+
+    m_pageCacheWarmer = new PageCacheWarmer(files, this);
+    m_pageCacheWarmer->start(QThread::IdlePriority);
+}
+
+QStringList MainWindow::sessionFiles() const
+{
+    QStringList files;
+    foreach (const QString& file, m_documents.keys())
     {
-        createLock();
-        return false;
+        if (QFileInfo(file).exists())
+            files << file;
     }
 
-    m_haveLock = true;
-    return false;
+    return files;
 }
 
-void MainWindow::createLock()
+void MainWindow::saveSession(const QStringList& files)
 {
-    QFile lock(Constants::SAKURASUITE_LOCK_FILE);
-    lock.open(QFile::WriteOnly);
-    lock.write(QString(QDateTime::currentDateTime().toString() + "\n").toLatin1());
-    lock.close();
-    m_haveLock = true;
+    m_settings->setValue(Constants::Settings::SAKURASUITE_SESSION_FILES, files);
 }
 
 void MainWindow::onPlugins()
@@ -964,8 +1049,7 @@ void MainWindow::onPlugins()
 
 void MainWindow::onClearRecent()
 {
-    QSettings settings;
-    settings.setValue(Constants::Settings::SAKURASUITE_RECENT_FILES, QVariant());
+    m_settings->remove(Constants::Settings::SAKURASUITE_RECENT_FILES);
 
     updateRecentFileActions();
 }
@@ -978,9 +1062,8 @@ void MainWindow::onRestoreDefault()
 
 void MainWindow::onCheckUpdate()
 {
-    QSettings settings;
-    if (!settings.value(Constants::Settings::SAKURASUITE_UPDATE_URL).isValid())
-        settings.setValue(Constants::Settings::SAKURASUITE_UPDATE_URL, Constants::Settings::SAKURASUITE_UPDATE_URL_DEFAULT);
+    if (!m_settings->contains(Constants::Settings::SAKURASUITE_UPDATE_URL))
+        m_settings->setValue(Constants::Settings::SAKURASUITE_UPDATE_URL, Constants::Settings::SAKURASUITE_UPDATE_URL_DEFAULT);
 
     m_updateMBox.setWindowTitle(Constants::SAKURASUITE_UPDATE_CHECKING);
     m_updateMBox.setText(Constants::SAKURASUITE_UPDATE_CHECKING_MSG);
@@ -996,7 +1079,7 @@ void MainWindow::onCheckUpdate()
 #ifdef SS_INTERNAL
     m_updater->checkForUpdate(Constants::Settings::SAKURASUITE_UPDATE_URL_DEFAULT, Constants::SAKURASUITE_APP_VERSION, Constants::SAKURASUITE_VERSION);
 #else
-    m_updater->checkForUpdate(settings.value(Constants::Settings::SAKURASUITE_UPDATE_URL).toString(), Constants::SAKURASUITE_APP_VERSION, Constants::SAKURASUITE_VERSION);
+    m_updater->checkForUpdate(m_settings->value<QString>(Constants::Settings::SAKURASUITE_UPDATE_URL), Constants::SAKURASUITE_APP_VERSION, Constants::SAKURASUITE_VERSION);
 #endif
 }
 
@@ -1005,8 +1088,18 @@ void MainWindow::onReload()
     if (!m_currentFile)
         return;
 
-    if (!m_currentFile->reload())
+    SessionRecorder::instance()->record("reload", cleanPath(m_currentFile->filePath()));
+    PageCacheWarmer::ForegroundIo foregroundIo;
+
+    Metrics::Timer timer("sakurasuite_reload_seconds", pluginName(m_currentFile));
+    PluginUsage::Scope usage(m_currentFile->loadedBy());
+    bool reloaded = m_currentFile->reload();
+    usage.finish();
+    timer.finish();
+
+    if (!reloaded)
     {
+        Metrics::instance()->counter("sakurasuite_reload_failures_total", pluginName(m_currentFile))->add();
         m_documents.remove(cleanPath(m_currentFile->filePath()));
         QListWidgetItem* item = NULL;
         for (int i = 0; i < ui->documentList->count(); i++)
@@ -1030,20 +1123,26 @@ void MainWindow::onReload()
         ui->statusBar->showMessage(tr("Reload successful..."), 2000);
 }
 
+bool MainWindow::checkWiiKeys()
+{
+    if (m_keyManager->isValid())
+        return true;
+
+    QMessageBox mbox(this);
+    mbox.setWindowTitle("Unable to export WiiSave...");
+    mbox.setText(tr("There are no keys specified for WiiSaves<br />"
+                    "Please set your keys in Edit->Preferences in order to export WiiSaves (data.bin)"));
+    mbox.exec();
+    return false;
+}
+
 void MainWindow::onExportWiiSave()
 {
     if (!m_currentFile)
         return;
 
-    if (!m_keyManager->isValid())
-    {
-        QMessageBox mbox(this);
-        mbox.setWindowTitle("Unable to export WiiSave...");
-        mbox.setText(tr("There are no keys specified for WiiSaves<br />"
-                        "Please set your keys in Edit->Preferences in order to export WiiSaves (data.bin)"));
-        mbox.exec();
+    if (!checkWiiKeys())
         return;
-    }
 
 
     GameDocument* gd = static_cast<GameDocument*>(m_currentFile);
@@ -1051,10 +1150,66 @@ void MainWindow::onExportWiiSave()
     if (!gd || !gd->supportsWiiSave())
         return;
 
-    if (gd->exportWiiSave())
+    Metrics::Timer timer("sakurasuite_export_wiisave_seconds", pluginName(gd));
+    bool exported = gd->exportWiiSave();
+    timer.finish();
+
+    if (exported)
         ui->statusBar->showMessage(tr("Export successful..."), 2000);
     else
+    {
+        Metrics::instance()->counter("sakurasuite_export_wiisave_failures_total", pluginName(gd))->add();
         ui->statusBar->showMessage(tr("Export failed..."), 2000);
+    }
+}
+
+void MainWindow::onBatchExportWiiSave()
+{
+    if (!checkWiiKeys())
+        return;
+
+    QList<GameDocument*> documents;
+    foreach (DocumentBase* document, m_documents.values())
+    {
+        GameDocument* gd = qobject_cast<GameDocument*>(document);
+        if (gd && gd->supportsWiiSave())
+            documents << gd;
+    }
+
+    m_batchExportDialog->setDocuments(documents);
+    m_batchExportDialog->exec();
+}
+
+void MainWindow::onSettingChanged(const QString& key, const QVariant& value)
+{
+    if (key == Constants::Settings::SAKURASUITE_ENGINE_DATA_PATH)
+        m_engineDataPath = QDir(value.toString());
+    else if (key == Constants::Settings::SAKURASUITE_ENGINE_EXECUTABLE)
+        m_engineExecutable = value.toUrl();
+}
+
+void MainWindow::onFindInData()
+{
+    m_searchDock->show();
+    m_searchDock->raise();
+    m_searchDock->focusPattern();
+}
+
+void MainWindow::onOpenSearchResult(const QString& file)
+{
+    if (m_documents.contains(cleanPath(file)))
+    {
+        for (int i = 0; i < ui->documentList->count(); i++)
+        {
+            if (ui->documentList->item(i)->data(FILEPATH).toString() == cleanPath(file))
+            {
+                ui->documentList->setCurrentRow(i);
+                return;
+            }
+        }
+    }
+
+    openFile(file);
 }
 
 void MainWindow::onStyleChanged()
@@ -1066,7 +1221,7 @@ void MainWindow::onStyleChanged()
         a->setChecked(true);
         if (style.contains("default"))
         {
-            QString tmp = QSettings().value(Constants::Settings::SAKURASUITE_DEFAULT_STYLE).toString();
+            QString tmp = m_settings->value<QString>(Constants::Settings::SAKURASUITE_DEFAULT_STYLE);
             qApp->setStyle(tmp);
             foreach (QAction* action, a->actionGroup()->actions())
             {
@@ -1079,8 +1234,8 @@ void MainWindow::onStyleChanged()
         }
         else
             qApp->setStyle(a->text());
-        QSettings().setValue(Constants::Settings::SAKURASUITE_CURRENT_STYLE, (style.contains("default") ?
-                                                                                  QSettings().value(Constants::Settings::SAKURASUITE_DEFAULT_STYLE).toString()
+        m_settings->setValue(Constants::Settings::SAKURASUITE_CURRENT_STYLE, (style.contains("default") ?
+                                                                                  m_settings->value<QString>(Constants::Settings::SAKURASUITE_DEFAULT_STYLE)
                                                                                 : style));
     }
 }
@@ -1105,11 +1260,19 @@ void MainWindow::onFileChanged(const QString& file)
         return;
     }
 
-    if (m_documents[cleanPath(file)]->reload())
+    PageCacheWarmer::ForegroundIo foregroundIo;
+    Metrics::Timer timer("sakurasuite_reload_seconds", pluginName(m_documents[cleanPath(file)]));
+    PluginUsage::Scope usage(m_documents[cleanPath(file)]->loadedBy());
+    bool reloaded = m_documents[cleanPath(file)]->reload();
+    usage.finish();
+    timer.finish();
+
+    if (reloaded)
         // Now we need to put the file back in the FS watcher
         m_fileSystemWatcher.addPath(file);
     else
     {
+        Metrics::instance()->counter("sakurasuite_reload_failures_total", pluginName(m_documents[cleanPath(file)]))->add();
         DocumentBase* f = m_documents.take(cleanPath(file));
         delete f;
         QListWidgetItem* item = NULL;
@@ -1132,8 +1295,15 @@ QString MainWindow::strippedName(const QString& fullFileName) const
     return QFileInfo(fullFileName).fileName();
 }
 
+QString MainWindow::pluginName(DocumentBase* document) const
+{
+    if (!document || !document->loadedBy())
+        return QString();
+
+    return document->loadedBy()->name();
+}
+
 QString MainWindow::mostRecentDirectory()
 {
-    QSettings settings;
-    return settings.value(Constants::Settings::SAKURASUITE_RECENT_DIRECTORY).toString();
+    return m_settings->value<QString>(Constants::Settings::SAKURASUITE_RECENT_DIRECTORY);
 }
@@ -0,0 +1,380 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+#include "Metrics.hpp"
+#include "Tracer.hpp"
+#include "Watchdog.hpp"
+#include <QCoreApplication>
+#include <QMutexLocker>
+#include <QStringList>
+#include <math.h>
+
+namespace
+{
+int highestBit(quint64 value)
+{
+    int bit = 0;
+    while (value >>= 1)
+        bit++;
+    return bit;
+}
+
+QString labels(const QString& plugin, const QString& extra = QString())
+{
+    QStringList pairs;
+    if (!plugin.isEmpty())
+    {
+        QString escaped = plugin;
+        escaped.replace("\\", "\\\\").replace("\"", "\\\"").replace("\n", "\\n");
+        pairs << QString("plugin=\"%1\"").arg(escaped);
+    }
+    if (!extra.isEmpty())
+        pairs << extra;
+
+    return pairs.isEmpty() ? QString() : QString("{%1}").arg(pairs.join(","));
+}
+
+QString seconds(qint64 usecs)
+{
+    return QString::number(usecs / 1000000.0, 'g', 9);
+}
+
+bool lessThan(const Metrics::Metric& a, const Metrics::Metric& b)
+{
+    if (a.name != b.name)
+        return a.name < b.name;
+    return a.plugin < b.plugin;
+}
+}
+
+Metrics* Metrics::m_instance = NULL;
+
+Metrics::Counter::Counter()
+    : m_value(0)
+{
+}
+
+void Metrics::Counter::add(qint64 n)
+{
+    m_value.fetchAndAddRelaxed(n);
+}
+
+qint64 Metrics::Counter::value() const
+{
+    return m_value.load();
+}
+
+void Metrics::Counter::reset()
+{
+    m_value.store(0);
+}
+
+Metrics::Gauge::Gauge()
+    : m_value(0)
+{
+}
+
+void Metrics::Gauge::set(qint64 value)
+{
+    m_value.store(value);
+}
+
+qint64 Metrics::Gauge::value() const
+{
+    return m_value.load();
+}
+
+void Metrics::Gauge::reset()
+{
+    m_value.store(0);
+}
+
+Metrics::Histogram::Histogram()
+    : m_count(0),
+      m_sum(0),
+      m_max(0)
+{
+    for (int i = 0; i < BucketCount; i++)
+        m_buckets[i].store(0);
+}
+
+int Metrics::Histogram::bucketIndex(qint64 value)
+{
+    if (value < SubBuckets)
+        return value < 0 ? 0 : (int)value;
+
+    int exponent = highestBit(value);
+    if (exponent > MaxExponent)
+        return BucketCount - 1;
+
+    int subBucket = (int)(value >> (exponent - SubBucketBits)) & (SubBuckets - 1);
+    return (exponent - SubBucketBits + 1) * SubBuckets + subBucket;
+}
+
+qint64 Metrics::Histogram::bucketValue(int index)
+{
+    if (index < SubBuckets)
+        return index;
+
+    int exponent = index / SubBuckets + SubBucketBits - 1;
+    qint64 subBucket = index % SubBuckets;
+    return (SubBuckets + subBucket) << (exponent - SubBucketBits);
+}
+
+void Metrics::Histogram::record(qint64 usecs)
+{
+    m_buckets[bucketIndex(usecs)].fetchAndAddRelaxed(1);
+    m_count.fetchAndAddRelaxed(1);
+    m_sum.fetchAndAddRelaxed(usecs);
+
+    qint64 max = m_max.load();
+    while (usecs > max && !m_max.testAndSetRelaxed(max, usecs))
+        max = m_max.load();
+}
+
+qint64 Metrics::Histogram::count() const
+{
+    return m_count.load();
+}
+
+qint64 Metrics::Histogram::sum() const
+{
+    return m_sum.load();
+}
+
+qint64 Metrics::Histogram::max() const
+{
+    return m_max.load();
+}
+
+qint64 Metrics::Histogram::quantile(double q) const
+{
+    qint64 count = m_count.load();
+    if (count == 0)
+        return 0;
+
+    qint64 target = qMax<qint64>(1, (qint64)ceil(q * count));
+    qint64 seen = 0;
+    for (int i = 0; i < BucketCount; i++)
+    {
+        seen += m_buckets[i].load();
+        if (seen >= target)
+        {
+            // Report the top of the bucket, never more than was actually recorded
+            if (i + 1 < BucketCount)
+                return qMin(bucketValue(i + 1) - 1, max());
+            return max();
+        }
+    }
+
+    return max();
+}
+
+void Metrics::Histogram::reset()
+{
+    for (int i = 0; i < BucketCount; i++)
+        m_buckets[i].store(0);
+    m_count.store(0);
+    m_sum.store(0);
+    m_max.store(0);
+}
+
+Metrics::Timer::Timer(const QString& name, const QString& plugin)
+    : m_name(name),
+      m_plugin(plugin),
+      m_finished(false)
+{
+    Tracer* tracer = Tracer::instance();
+    m_traced = tracer->isEnabled();
+    if (m_traced)
+        tracer->begin(m_plugin.isEmpty() ? QString("core") : m_plugin, m_name);
+    m_watched = Watchdog::enter(m_plugin.isEmpty() ? m_name : QString("%1 (%2)").arg(m_name).arg(m_plugin));
+
+    m_timer.start();
+}
+
+Metrics::Timer::~Timer()
+{
+    finish();
+}
+
+void Metrics::Timer::finish()
+{
+    if (m_finished)
+        return;
+
+    m_finished = true;
+    Metrics::instance()->histogram(m_name, m_plugin)->record(elapsed());
+    if (m_traced)
+        Tracer::instance()->end();
+    if (m_watched)
+        Watchdog::leave();
+}
+
+void Metrics::Timer::setPlugin(const QString& plugin)
+{
+    m_plugin = plugin;
+}
+
+qint64 Metrics::Timer::elapsed() const
+{
+    return m_timer.nsecsElapsed() / 1000;
+}
+
+Metrics::Metrics()
+    : QObject(qApp)
+{
+}
+
+Metrics::~Metrics()
+{
+    foreach (const Metric& metric, m_metrics)
+    {
+        switch (metric.type)
+        {
+            case CounterType:
+                delete static_cast<Counter*>(metric.data);
+                break;
+            case GaugeType:
+                delete static_cast<Gauge*>(metric.data);
+                break;
+            case HistogramType:
+                delete static_cast<Histogram*>(metric.data);
+                break;
+        }
+    }
+
+    m_instance = NULL;
+}
+
+Metrics* Metrics::instance()
+{
+    if (!m_instance)
+        m_instance = new Metrics;
+    return m_instance;
+}
+
+Metrics::Counter* Metrics::counter(const QString& name, const QString& plugin)
+{
+    return static_cast<Counter*>(find(name, plugin, CounterType));
+}
+
+Metrics::Gauge* Metrics::gauge(const QString& name, const QString& plugin)
+{
+    return static_cast<Gauge*>(find(name, plugin, GaugeType));
+}
+
+Metrics::Histogram* Metrics::histogram(const QString& name, const QString& plugin)
+{
+    return static_cast<Histogram*>(find(name, plugin, HistogramType));
+}
+
+void* Metrics::find(const QString& name, const QString& plugin, Metrics::Type type)
+{
+    QString key = name + QChar(0) + plugin;
+    QMutexLocker locker(&m_mutex);
+    QHash<QString, Metric>::const_iterator it = m_metrics.constFind(key);
+    if (it != m_metrics.constEnd())
+    {
+        Q_ASSERT(it.value().type == type);
+        return it.value().data;
+    }
+
+    Metric metric = {name, plugin, type, NULL};
+    switch (type)
+    {
+        case CounterType:
+            metric.data = new Counter;
+            break;
+        case GaugeType:
+            metric.data = new Gauge;
+            break;
+        case HistogramType:
+            metric.data = new Histogram;
+            break;
+    }
+
+    m_metrics[key] = metric;
+    return metric.data;
+}
+
+QList<Metrics::Metric> Metrics::metrics() const
+{
+    QMutexLocker locker(&m_mutex);
+    QList<Metric> metrics = m_metrics.values();
+    qSort(metrics.begin(), metrics.end(), lessThan);
+    return metrics;
+}
+
+void Metrics::reset()
+{
+    foreach (const Metric& metric, metrics())
+    {
+        switch (metric.type)
+        {
+            case CounterType:
+                static_cast<Counter*>(metric.data)->reset();
+                break;
+            case GaugeType:
+                // Gauges describe the current state, there's nothing to reset
+                break;
+            case HistogramType:
+                static_cast<Histogram*>(metric.data)->reset();
+                break;
+        }
+    }
+}
+
+QString Metrics::toPrometheus() const
+{
+    static const double quantiles[] = {0.5, 0.9, 0.99, 1.0};
+
+    QString text;
+    QString lastName;
+    foreach (const Metric& metric, metrics())
+    {
+        if (metric.name != lastName)
+        {
+            static const char* types[] = {"counter", "gauge", "summary"};
+            text += QString("# TYPE %1 %2\n").arg(metric.name).arg(types[metric.type]);
+            lastName = metric.name;
+        }
+
+        switch (metric.type)
+        {
+            case CounterType:
+                text += QString("%1%2 %3\n").arg(metric.name).arg(labels(metric.plugin)).arg(static_cast<Counter*>(metric.data)->value());
+                break;
+            case GaugeType:
+                text += QString("%1%2 %3\n").arg(metric.name).arg(labels(metric.plugin)).arg(static_cast<Gauge*>(metric.data)->value());
+                break;
+            case HistogramType:
+            {
+                Histogram* histogram = static_cast<Histogram*>(metric.data);
+                for (unsigned i = 0; i < sizeof(quantiles) / sizeof(quantiles[0]); i++)
+                {
+                    text += QString("%1%2 %3\n").arg(metric.name)
+                            .arg(labels(metric.plugin, QString("quantile=\"%1\"").arg(quantiles[i])))
+                            .arg(seconds(histogram->quantile(quantiles[i])));
+                }
+                text += QString("%1_sum%2 %3\n").arg(metric.name).arg(labels(metric.plugin)).arg(seconds(histogram->sum()));
+                text += QString("%1_count%2 %3\n").arg(metric.name).arg(labels(metric.plugin)).arg(histogram->count());
+                break;
+            }
+        }
+    }
+
+    return text;
+}
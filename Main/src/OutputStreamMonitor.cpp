@@ -1,8 +1,10 @@
 #include "OutputStreamMonitor.hpp"
-#include <stdio.h>
+#include <string.h>
 
 OutputStreamMonitor::OutputStreamMonitor(std::ostream& stream)
-    : m_stream(stream)
+    : m_stream(stream),
+      m_buffered(0),
+      m_flushScheduled(false)
 {
     m_oldBuf = stream.rdbuf();
     stream.rdbuf(this);
@@ -10,43 +12,157 @@ OutputStreamMonitor::OutputStreamMonitor(std::ostream& stream)
 
 OutputStreamMonitor::~OutputStreamMonitor()
 {
-    // output anything that is left
-    if (!m_string.empty())
-        emit messageRecieved(QString::fromStdString(m_string));
     m_stream.rdbuf(m_oldBuf);
+    processBuffer();
+    m_oldBuf->pubsync();
+
+    // output anything that is left
+    if (!m_partial.empty())
+        m_pending << QString::fromLocal8Bit(m_partial.data(), (int)m_partial.size());
+    if (!m_pending.isEmpty())
+        emit messagesRecieved(m_pending);
+}
+
+void OutputStreamMonitor::flush()
+{
+    QStringList lines;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_flushScheduled = false;
+        lines.swap(m_pending);
+    }
+
+    if (!lines.isEmpty())
+        emit messagesRecieved(lines);
 }
 
 std::basic_streambuf<char>::int_type OutputStreamMonitor::overflow(std::basic_streambuf<char>::int_type v)
 {
-    if (v == '\n')
+    // There is no put area, so every single character ends up here
+    if (!traits_type::eq_int_type(v, traits_type::eof()))
     {
-        emit messageRecieved(QString::fromStdString(m_string));
-        fprintf(stdout, "%s", m_string.c_str());
-        m_string = "";
-        m_string.clear();
+        char c = traits_type::to_char_type(v);
+        write(&c, 1);
     }
-    else
-        m_string += v;
 
-    return v;
+    return traits_type::not_eof(v);
 }
 
 std::streamsize OutputStreamMonitor::xsputn(const char* p, std::streamsize n)
 {
-    m_string.append(p, p + n);
+    write(p, (std::size_t)n);
+    return n;
+}
 
-    std::string::size_type pos = 0;
-    while (pos != std::string::npos)
+int OutputStreamMonitor::sync()
+{
+    QStringList lines;
+    int result;
     {
-        pos = m_string.find('\n');
-        if (pos != std::string::npos)
+        QMutexLocker locker(&m_mutex);
+        processBuffer();
+        result = m_oldBuf->pubsync();
+        lines = schedule();
+    }
+
+    if (!lines.isEmpty())
+        emit messagesRecieved(lines);
+    return result;
+}
+
+void OutputStreamMonitor::write(const char* data, std::size_t size)
+{
+    const char* lastNewline = NULL;
+    for (const char* p = data + size; p != data; p--)
+    {
+        if (p[-1] == '\n')
         {
-            std::string tmp(m_string.begin(), m_string.begin() + pos);
-            emit messageRecieved(QString::fromStdString(tmp));
-            m_string = "";
-            m_string.clear();
+            lastNewline = p - 1;
+            break;
         }
     }
 
-    return n;
+    QStringList lines;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (lastNewline)
+        {
+            // Complete lines go out right away, only the rest waits
+            std::size_t complete = lastNewline + 1 - data;
+            append(data, complete);
+            processBuffer();
+            data += complete;
+            size -= complete;
+        }
+        append(data, size);
+        lines = schedule();
+    }
+
+    // Not under the lock, a direct connection may well write to the stream again
+    if (!lines.isEmpty())
+        emit messagesRecieved(lines);
+}
+
+QStringList OutputStreamMonitor::schedule()
+{
+    QStringList lines;
+    if (m_pending.size() >= MaxPendingLines)
+    {
+        // Don't let a runaway writer pile up lines until the event loop gets to them
+        lines.swap(m_pending);
+    }
+    else if (!m_pending.isEmpty() && !m_flushScheduled)
+    {
+        m_flushScheduled = true;
+        QMetaObject::invokeMethod(this, "flush", Qt::QueuedConnection);
+    }
+
+    return lines;
+}
+
+void OutputStreamMonitor::append(const char* data, std::size_t size)
+{
+    if (size > BufferSize - m_buffered)
+        processBuffer();
+
+    // Too big for the buffer, don't bother copying it
+    if (size >= BufferSize)
+    {
+        process(data, size);
+        return;
+    }
+
+    memcpy(m_buffer + m_buffered, data, size);
+    m_buffered += size;
+}
+
+void OutputStreamMonitor::processBuffer()
+{
+    if (m_buffered)
+        process(m_buffer, m_buffered);
+    m_buffered = 0;
+}
+
+void OutputStreamMonitor::process(const char* data, std::size_t size)
+{
+    m_oldBuf->sputn(data, size);
+
+    const char* end = data + size;
+    while (const char* newline = (const char*)memchr(data, '\n', end - data))
+    {
+        if (m_partial.empty())
+        {
+            m_pending << QString::fromLocal8Bit(data, (int)(newline - data));
+        }
+        else
+        {
+            m_partial.append(data, newline);
+            m_pending << QString::fromLocal8Bit(m_partial.data(), (int)m_partial.size());
+            m_partial.clear();
+        }
+
+        data = newline + 1;
+    }
+
+    m_partial.append(data, end);
 }
@@ -0,0 +1,107 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+#include "PageCacheWarmer.hpp"
+#include <QFile>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+// Plugins decide what they can load from the first few bytes,
+// so the header is always read even where readahead hints exist.
+const qint64 HeaderSize  = 4096;
+#ifndef Q_OS_LINUX
+// Without a readahead hint we read the file ourselves, in chunks,
+// checking between chunks whether the user started doing I/O.
+const qint64 ChunkSize   = 1024 * 1024;
+const qint64 MaxWarmSize = 256 * 1024 * 1024;
+#endif
+}
+
+QAtomicInt PageCacheWarmer::m_foregroundIo;
+
+PageCacheWarmer::ForegroundIo::ForegroundIo()
+{
+    m_foregroundIo.ref();
+}
+
+PageCacheWarmer::ForegroundIo::~ForegroundIo()
+{
+    m_foregroundIo.deref();
+}
+
+PageCacheWarmer::PageCacheWarmer(const QStringList& files, QObject* parent)
+    : QThread(parent),
+      m_files(files)
+{
+}
+
+PageCacheWarmer::~PageCacheWarmer()
+{
+    stop();
+    wait();
+}
+
+void PageCacheWarmer::stop()
+{
+    m_stop.store(1);
+}
+
+void PageCacheWarmer::run()
+{
+    foreach (const QString& file, m_files)
+    {
+        waitForForeground();
+        if (m_stop.load())
+            return;
+
+        warm(file);
+    }
+}
+
+void PageCacheWarmer::warm(const QString& file)
+{
+    QFile f(file);
+    if (!f.open(QFile::ReadOnly))
+        return;
+
+    char header[HeaderSize];
+    f.read(header, HeaderSize);
+
+#ifdef Q_OS_LINUX
+    ::posix_fadvise(f.handle(), 0, 0, POSIX_FADV_WILLNEED);
+#else
+    QByteArray chunk(ChunkSize, Qt::Uninitialized);
+    qint64 total = HeaderSize;
+    while (total < MaxWarmSize && !m_stop.load())
+    {
+        waitForForeground();
+        qint64 read = f.read(chunk.data(), ChunkSize);
+        if (read <= 0)
+            break;
+        total += read;
+    }
+#endif
+}
+
+void PageCacheWarmer::waitForForeground()
+{
+    while (m_foregroundIo.load() > 0 && !m_stop.load())
+        msleep(100);
+}
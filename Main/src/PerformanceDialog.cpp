@@ -0,0 +1,215 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+#include "PerformanceDialog.hpp"
+#include "ui_PerformanceDialog.h"
+#include "Metrics.hpp"
+#include "Tracer.hpp"
+#include "AllocationProfiler.hpp"
+#include "SettingsStore.hpp"
+#include "Constants.hpp"
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QMessageBox>
+#include <QTextStream>
+
+namespace
+{
+QString milliseconds(qint64 usecs)
+{
+    return QString::number(usecs / 1000.0, 'f', 3);
+}
+}
+
+PerformanceDialog::PerformanceDialog(QWidget* parent) :
+    QDialog(parent),
+    ui(new Ui::PerformanceDialog)
+{
+    ui->setupUi(this);
+    // Only there in builds with SS_ALLOC_PROFILING
+    ui->allocationTreeWidget->setVisible(AllocationProfiler::isEnabled());
+
+    m_refreshTimer.setInterval(1000);
+    connect(&m_refreshTimer, SIGNAL(timeout()), this, SLOT(updateMetrics()));
+}
+
+PerformanceDialog::~PerformanceDialog()
+{
+    delete ui;
+}
+
+void PerformanceDialog::showEvent(QShowEvent* se)
+{
+    QDialog::showEvent(se);
+
+    // Tracing may have been started from the environment
+    ui->traceCheckBox->setChecked(Tracer::instance()->isEnabled());
+    updateMetrics();
+    m_refreshTimer.start();
+}
+
+void PerformanceDialog::hideEvent(QHideEvent* he)
+{
+    m_refreshTimer.stop();
+
+    QDialog::hideEvent(he);
+}
+
+void PerformanceDialog::updateMetrics()
+{
+    QTreeWidget* tw = ui->treeWidget;
+    QList<Metrics::Metric> metrics = Metrics::instance()->metrics();
+
+    // Metrics are never removed, so existing rows keep their place
+    for (int i = 0; i < metrics.count(); i++)
+    {
+        const Metrics::Metric& metric = metrics.at(i);
+        QTreeWidgetItem* item = NULL;
+        for (int j = 0; j < tw->topLevelItemCount(); j++)
+        {
+            QTreeWidgetItem* existing = tw->topLevelItem(j);
+            if (existing->text(MetricColumn) == metric.name && existing->text(PluginColumn) == metric.plugin)
+            {
+                item = existing;
+                break;
+            }
+        }
+
+        if (!item)
+        {
+            item = new QTreeWidgetItem;
+            item->setText(MetricColumn, metric.name);
+            item->setText(PluginColumn, metric.plugin);
+            tw->addTopLevelItem(item);
+        }
+
+        switch (metric.type)
+        {
+            case Metrics::CounterType:
+                item->setText(CountColumn, QString::number(static_cast<Metrics::Counter*>(metric.data)->value()));
+                break;
+            case Metrics::GaugeType:
+                item->setText(CountColumn, QString::number(static_cast<Metrics::Gauge*>(metric.data)->value()));
+                break;
+            case Metrics::HistogramType:
+            {
+                Metrics::Histogram* histogram = static_cast<Metrics::Histogram*>(metric.data);
+                qint64 count = histogram->count();
+                item->setText(CountColumn, QString::number(count));
+                item->setText(MeanColumn, milliseconds(count ? histogram->sum() / count : 0));
+                item->setText(P50Column, milliseconds(histogram->quantile(0.5)));
+                item->setText(P90Column, milliseconds(histogram->quantile(0.9)));
+                item->setText(P99Column, milliseconds(histogram->quantile(0.99)));
+                item->setText(MaxColumn, milliseconds(histogram->max()));
+                break;
+            }
+        }
+    }
+
+    if (AllocationProfiler::isEnabled())
+        updateAllocations();
+}
+
+void PerformanceDialog::updateAllocations()
+{
+    QTreeWidget* tw = ui->allocationTreeWidget;
+    foreach (const AllocationProfiler::Usage& usage, AllocationProfiler::usage())
+    {
+        // Tags are never removed either
+        QTreeWidgetItem* item = NULL;
+        for (int i = 0; i < tw->topLevelItemCount(); i++)
+        {
+            if (tw->topLevelItem(i)->text(AllocationTagColumn) == usage.tag)
+            {
+                item = tw->topLevelItem(i);
+                break;
+            }
+        }
+
+        if (!item)
+        {
+            item = new QTreeWidgetItem;
+            item->setText(AllocationTagColumn, usage.tag);
+            tw->addTopLevelItem(item);
+        }
+
+        // Numbers rather than text, so they sort as numbers
+        item->setData(AllocationsColumn, Qt::DisplayRole, usage.allocations);
+        item->setData(AllocatedColumn, Qt::DisplayRole, qRound64(usage.bytes / 1024.0));
+        item->setData(LiveColumn, Qt::DisplayRole, qRound64(usage.live / 1024.0));
+        item->setData(PeakColumn, Qt::DisplayRole, qRound64(usage.peak / 1024.0));
+    }
+}
+
+void PerformanceDialog::onReset()
+{
+    Metrics::instance()->reset();
+    AllocationProfiler::reset();
+    updateMetrics();
+}
+
+void PerformanceDialog::onSave()
+{
+    QString rd = SettingsStore::instance()->value<QString>(Constants::Settings::SAKURASUITE_RECENT_DIRECTORY);
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Save metrics..."), rd, "*.prom");
+    if (fileName.isEmpty())
+        return;
+
+    if (QFileInfo(fileName).suffix() != "prom")
+        fileName += ".prom";
+
+    QFile file(fileName);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate | QFile::Text))
+    {
+        QMessageBox::warning(this, tr("Save metrics..."), tr("Unable to write %1: %2").arg(fileName).arg(file.errorString()));
+        return;
+    }
+
+    QTextStream stream(&file);
+    stream << Metrics::instance()->toPrometheus();
+    SettingsStore::instance()->setValue(Constants::Settings::SAKURASUITE_RECENT_DIRECTORY, QFileInfo(fileName).absolutePath());
+}
+
+void PerformanceDialog::onTraceToggled(bool enabled)
+{
+    Tracer* tracer = Tracer::instance();
+    if (enabled == tracer->isEnabled())
+        return;
+
+    // A new recording starts with an empty timeline
+    if (enabled)
+        tracer->clear();
+    tracer->setEnabled(enabled);
+}
+
+void PerformanceDialog::onSaveTrace()
+{
+    QString rd = SettingsStore::instance()->value<QString>(Constants::Settings::SAKURASUITE_RECENT_DIRECTORY);
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Save trace..."), rd, "*.json");
+    if (fileName.isEmpty())
+        return;
+
+    if (QFileInfo(fileName).suffix() != "json")
+        fileName += ".json";
+
+    QString error;
+    if (!Tracer::instance()->save(fileName, &error))
+    {
+        QMessageBox::warning(this, tr("Save trace..."), tr("Unable to write %1: %2").arg(fileName).arg(error));
+        return;
+    }
+
+    SettingsStore::instance()->setValue(Constants::Settings::SAKURASUITE_RECENT_DIRECTORY, QFileInfo(fileName).absolutePath());
+}
@@ -0,0 +1,137 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+#include "PluginUsage.hpp"
+#include <PluginInterface.hpp>
+#include <QCoreApplication>
+
+#if defined(Q_OS_LINUX)
+#include <malloc.h>
+#elif defined(Q_OS_MAC)
+#include <malloc/malloc.h>
+#elif defined(Q_OS_WIN)
+#define PSAPI_VERSION 2
+#include <windows.h>
+#include <psapi.h>
+#endif
+
+PluginUsage* PluginUsage::m_instance = NULL;
+
+PluginUsage::Usage::Usage()
+    : calls(0),
+      usecs(0),
+      heapGrowth(0)
+{
+}
+
+PluginUsage::Scope::Scope(PluginInterface* plugin, Measure measure)
+    : m_plugin(plugin ? plugin->name() : QString()),
+      m_heap(measure == TimeAndHeap ? heapInUse() : -1),
+      m_allocations(m_plugin)
+{
+    m_timer.start();
+}
+
+PluginUsage::Scope::~Scope()
+{
+    finish();
+}
+
+void PluginUsage::Scope::finish()
+{
+    if (m_plugin.isEmpty())
+        return;
+
+    qint64 heap = m_heap < 0 ? -1 : heapInUse();
+    PluginUsage::instance()->add(m_plugin, m_timer.nsecsElapsed() / 1000, (heap < 0 || m_heap < 0) ? 0 : heap - m_heap);
+    m_plugin.clear();
+}
+
+PluginUsage::PluginUsage()
+    : QObject(qApp)
+{
+}
+
+PluginUsage::~PluginUsage()
+{
+    m_instance = NULL;
+}
+
+PluginUsage* PluginUsage::instance()
+{
+    if (!m_instance)
+        m_instance = new PluginUsage;
+    return m_instance;
+}
+
+PluginUsage::Usage PluginUsage::usage(const QString& plugin) const
+{
+    return m_usage.value(plugin);
+}
+
+void PluginUsage::reset()
+{
+    QStringList plugins = m_usage.keys();
+    m_usage.clear();
+    foreach (const QString& plugin, plugins)
+        emit usageChanged(plugin);
+}
+
+void PluginUsage::add(const QString& plugin, qint64 usecs, qint64 heapGrowth)
+{
+    Usage& usage = m_usage[plugin];
+    usage.calls++;
+    usage.usecs += usecs;
+    usage.heapGrowth += heapGrowth;
+
+    // preferredPlugin() charges every plugin on every open, tell the dialog once
+    if (m_changed.isEmpty())
+        QMetaObject::invokeMethod(this, "emitUsageChanged", Qt::QueuedConnection);
+    m_changed.insert(plugin);
+}
+
+void PluginUsage::emitUsageChanged()
+{
+    QSet<QString> changed;
+    changed.swap(m_changed);
+    foreach (const QString& plugin, changed)
+        emit usageChanged(plugin);
+}
+
+qint64 PluginUsage::heapInUse()
+{
+#if defined(Q_OS_LINUX) && defined(__GLIBC__)
+#if __GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33)
+    struct mallinfo2 info = mallinfo2();
+#else
+    struct mallinfo info = mallinfo();
+#endif
+    // Small blocks plus whatever was mmapped for large ones, summed over every
+    // arena. That takes each arena's lock in turn, so it isn't cheap either.
+    return (qint64)info.uordblks + (qint64)info.hblkhd;
+#elif defined(Q_OS_MAC)
+    malloc_statistics_t stats;
+    malloc_zone_statistics(NULL, &stats);
+    return stats.size_in_use;
+#elif defined(Q_OS_WIN)
+    // The process' private bytes, the closest thing that's cheap to query
+    PROCESS_MEMORY_COUNTERS_EX counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), (PROCESS_MEMORY_COUNTERS*)&counters, sizeof(counters)))
+        return -1;
+    return counters.PrivateUsage;
+#else
+    return -1;
+#endif
+}
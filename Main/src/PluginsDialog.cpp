@@ -18,6 +18,7 @@
 #include "PluginInterface.hpp"
 #include "PluginsManager.hpp"
 #include "Constants.hpp"
+#include "PluginUsage.hpp"
 #include <PluginSettingsDialog.hpp>
 #include <Updater.hpp>
 #include <QMessageBox>
@@ -31,6 +32,7 @@ PluginsDialog::PluginsDialog(QWidget *parent, PluginsManager* pluginsManager) :
     ui->groupBox->setEnabled(false);
 
     connect(&m_statusTimer, SIGNAL(timeout()), this, SLOT(onTimeOut()));
+    connect(PluginUsage::instance(), SIGNAL(usageChanged(QString)), this, SLOT(onUsageChanged(QString)));
 }
 
 PluginsDialog::~PluginsDialog()
@@ -48,31 +50,77 @@ void PluginsDialog::showEvent(QShowEvent* se)
 void PluginsDialog::updatePluginData()
 {
     QTreeWidget* tw = ui->treeWidget;
-    tw->clear();
-    ui->authorValue->clear();
-    ui->descriptionTextEdit->clear();
-    ui->websiteValue->clear();
-    ui->pathValue->clear();
-    ui->licenseValue->clear();
-    ui->descriptionTextEdit->clear();
+
+    // Rows are updated in place so the selection and scroll position survive
+    for (int i = tw->topLevelItemCount() - 1; i >= 0; i--)
+    {
+        if (!m_pluginsManager->plugin(tw->topLevelItem(i)->text(NameColumn)))
+            delete tw->takeTopLevelItem(i);
+    }
+
     foreach(PluginInterface* plugin, m_pluginsManager->plugins())
     {
         if (!plugin)
             continue;
 
-        QTreeWidgetItem* item = new QTreeWidgetItem;
+        QTreeWidgetItem* item = findItem(plugin->name());
+        if (!item)
+        {
+            item = new QTreeWidgetItem;
+            item->setText(NameColumn, plugin->name());
+            tw->addTopLevelItem(item);
+        }
+
         item->setIcon(NameColumn, plugin->icon());
-        item->setText(NameColumn, plugin->name());
         item->setText(VersionColumn, plugin->version());
         item->setText(ExtensionColumn, plugin->extension());
         item->setCheckState(EnabledColumn, (plugin->enabled() ? Qt::Checked : Qt::Unchecked));
+        updateUsage(item);
 
+        // A reloaded plugin comes with a new updater
         if (plugin->hasUpdater() && plugin->updater())
-            connect(plugin->updater(), SIGNAL(warning(QString)), this, SLOT(onPluginWarning(QString)));
+            connect(plugin->updater(), SIGNAL(warning(QString)), this, SLOT(onPluginWarning(QString)), Qt::UniqueConnection);
+    }
 
-        tw->addTopLevelItem(item);
+    onItemSelectionChanged();
+}
+
+QTreeWidgetItem* PluginsDialog::findItem(const QString& name) const
+{
+    for (int i = 0; i < ui->treeWidget->topLevelItemCount(); i++)
+    {
+        QTreeWidgetItem* item = ui->treeWidget->topLevelItem(i);
+        if (item->text(NameColumn) == name)
+            return item;
     }
-    ui->groupBox->setEnabled(false);
+
+    return NULL;
+}
+
+void PluginsDialog::updateUsage(QTreeWidgetItem* item)
+{
+    PluginUsage::Usage usage = PluginUsage::instance()->usage(item->text(NameColumn));
+    // Stored as numbers so the columns sort properly
+    item->setData(TimeColumn, Qt::DisplayRole, qRound(usage.usecs / 100.0) / 10.0);
+    item->setData(HeapColumn, Qt::DisplayRole, qRound(usage.heapGrowth / 102.4) / 10.0);
+    QString toolTip = tr("%1 calls").arg(usage.calls);
+    item->setToolTip(TimeColumn, toolTip);
+    item->setToolTip(HeapColumn, toolTip);
+}
+
+void PluginsDialog::onUsageChanged(const QString& plugin)
+{
+    if (!isVisible())
+        return;
+
+    QTreeWidgetItem* item = findItem(plugin);
+    if (item)
+        updateUsage(item);
+}
+
+void PluginsDialog::onResetUsage()
+{
+    PluginUsage::instance()->reset();
 }
 
 void PluginsDialog::onItemSelectionChanged()
@@ -17,9 +17,14 @@
 #include "MainWindow.hpp"
 #include "PluginsDialog.hpp"
 #include "PluginInterface.hpp"
+#include "SettingsStore.hpp"
+#include "ApplicationLog.hpp"
+#include "Metrics.hpp"
+#include "PluginUsage.hpp"
 #include <QApplication>
 #include <QPluginLoader>
 #include <QDir>
+#include <QFileInfo>
 
 PluginsManager::PluginsManager(MainWindow* parent)
     : QObject(parent),
@@ -30,6 +35,8 @@ PluginsManager::PluginsManager(MainWindow* parent)
 
 PluginsManager::~PluginsManager()
 {
+    // Queued messages point at source locations inside the plugins
+    ApplicationLog::instance()->drain();
     foreach (QPluginLoader* loader, m_pluginLoaders.values())
     {
         if (loader->isLoaded())
@@ -77,6 +84,7 @@ bool PluginsManager::reloadByName(const QString& name)
     if (!loader)
         return false;
 
+    ApplicationLog::instance()->drain();
     if(loader->unload())
     {
         delete loader;
@@ -95,11 +103,13 @@ bool PluginsManager::reloadByName(const QString& name)
                 newPlugin->setPath(pluginPath);
                 newPlugin->object()->setParent(parent());
                 m_mainWindow->addFileFilter(newPlugin->filter());
-                QSettings settings;
-                settings.beginGroup(newPlugin->name());
-                newPlugin->setEnabled(settings.value("enabled", true).toBool());
+                newPlugin->setEnabled(SettingsStore::instance()->value<bool>(newPlugin->name() + "/enabled", true));
                 qDebug() << newPlugin->author();
-                newPlugin->initialize(m_mainWindow);
+                {
+                    Metrics::Timer initializeTimer("sakurasuite_plugin_initialize_seconds", newPlugin->name());
+                    PluginUsage::Scope usage(newPlugin);
+                    newPlugin->initialize(m_mainWindow);
+                }
                 connect(newPlugin->object(), SIGNAL(newDocument(DocumentBase*)), m_mainWindow, SLOT(onNewDocument(DocumentBase*)));
                 m_plugins.append(newPlugin);
                 qDebug() << "Loaded plugin " << plugin->name();
@@ -135,9 +145,16 @@ QList<PluginInterface*> PluginsManager::plugins()
 
 PluginInterface* PluginsManager::preferredPlugin(const QString& file)
 {
+    Metrics::Timer timer("sakurasuite_preferred_plugin_seconds");
     foreach (PluginInterface* plugin, m_plugins)
     {
-        if (plugin->enabled() && plugin->canLoad(file))
+        if (!plugin->enabled())
+            continue;
+
+        // Every probe is timed on its own, a slow canLoad delays every open
+        Metrics::Timer probeTimer("sakurasuite_can_load_seconds", plugin->name());
+        PluginUsage::Scope usage(plugin, PluginUsage::TimeOnly);
+        if (plugin->canLoad(file))
             return plugin;
     }
 
@@ -150,6 +167,26 @@ void PluginsManager::unloadPlugins()
 
 void PluginsManager::loadPlugins()
 {
+    Metrics::Timer timer("sakurasuite_load_plugins_seconds");
+    QDir pluginsDir = pluginsDirectory();
+    if (!pluginsDir.exists())
+    {
+        qCritical() << "Unable to acquire plugin directory";
+        return;
+    }
+
+    foreach (QString fileName, pluginsDir.entryList(QStringList() << Constants::SAKURASUITE_PLUGIN_EXTENSION, QDir::Files))
+        loadPlugin(pluginsDir.absoluteFilePath(fileName));
+
+    Metrics::instance()->gauge("sakurasuite_plugins_loaded")->set(m_plugins.count());
+}
+
+QDir PluginsManager::pluginsDirectory()
+{
+    QByteArray path = qgetenv("SAKURASUITE_PLUGIN_PATH");
+    if (!path.isEmpty())
+        return QDir(QString::fromLocal8Bit(path));
+
     QDir pluginsDir(qApp->applicationDirPath());
 #if defined(Q_OS_WIN)
     if (pluginsDir.dirName().toLower() == "debug" || pluginsDir.dirName().toLower() == "release")
@@ -168,59 +205,66 @@ void PluginsManager::loadPlugins()
     {
         pluginsDir = QDir(Constants::SAKURASUITE_HOME_PATH);
         if (!pluginsDir.cd("plugins"))
-        {
-            qCritical() << "Unable to acquire plugin directory";
-            return;
-        }
+            return QDir(Constants::SAKURASUITE_HOME_PATH + "/plugins");
     }
 
-    foreach (QString fileName, pluginsDir.entryList(QStringList() << Constants::SAKURASUITE_PLUGIN_EXTENSION, QDir::Files))
+    return pluginsDir;
+}
+
+bool PluginsManager::loadPlugin(const QString& path)
+{
+    QString fileName = QFileInfo(path).fileName();
+    QPluginLoader* loader = new QPluginLoader(path);
+    if (!loader->instance())
     {
-        QPluginLoader* loader = new QPluginLoader(pluginsDir.absoluteFilePath(fileName));
-        if (loader->instance())
-        {
-            PluginInterface* plugin = qobject_cast<PluginInterface *>(loader->instance());
-            if (plugin)
-            {
-                if (!this->plugin(plugin->name()))
-                {
-                    m_plugins.append(plugin);
-                    connect(plugin->object(), SIGNAL(enabledChanged()), this, SLOT(onEnabledChanged()));
-                    plugin->object()->setParent(this->parent());
-                    m_mainWindow->addFileFilter(plugin->filter());
-                    QSettings settings;
-                    settings.beginGroup(plugin->name());
-                    plugin->setPath(pluginsDir.absoluteFilePath(fileName));
-                    plugin->setEnabled(settings.value("enabled", true).toBool());
-                    plugin->initialize(m_mainWindow);
-                    connect(plugin->object(), SIGNAL(newDocument(DocumentBase*)), m_mainWindow, SLOT(onNewDocument(DocumentBase*)));
-                    m_pluginLoaders[plugin->name().toLower()] = loader;
-                    qDebug() << "Loaded plugin " << plugin->name();
-                }
-                else
-                {
-                    qWarning() << tr("Error loading %1: Plugin with name '%2' already exists")
-                                        .arg(fileName)
-                                        .arg(plugin->name());
-                    loader->unload();
-                    delete loader;
-                }
-            }
-            else
-            {
-                loader->unload();
-                qWarning() << tr("Error loading %1: PluginInterface cast failed").arg(fileName);
-                delete loader;
-                loader = NULL;
-            }
-        }
-        else
-        {
-            qWarning() << tr("Error loading %1: %2").arg(fileName).arg(loader->errorString());
-            delete loader;
-            loader = NULL;
-        }
+        qWarning() << tr("Error loading %1: %2").arg(fileName).arg(loader->errorString());
+        delete loader;
+        return false;
+    }
+
+    PluginInterface* plugin = qobject_cast<PluginInterface *>(loader->instance());
+    if (!plugin)
+    {
+        loader->unload();
+        qWarning() << tr("Error loading %1: PluginInterface cast failed").arg(fileName);
+        delete loader;
+        return false;
+    }
+
+    plugin->setPath(path);
+    if (!registerPlugin(plugin, loader))
+    {
+        qWarning() << tr("Error loading %1: Plugin with name '%2' already exists")
+                            .arg(fileName)
+                            .arg(plugin->name());
+        loader->unload();
+        delete loader;
+        return false;
+    }
+
+    return true;
+}
+
+bool PluginsManager::registerPlugin(PluginInterface* plugin, QPluginLoader* loader)
+{
+    if (this->plugin(plugin->name()))
+        return false;
+
+    m_plugins.append(plugin);
+    connect(plugin->object(), SIGNAL(enabledChanged()), this, SLOT(onEnabledChanged()));
+    plugin->object()->setParent(this->parent());
+    m_mainWindow->addFileFilter(plugin->filter());
+    plugin->setEnabled(SettingsStore::instance()->value<bool>(plugin->name() + "/enabled", true));
+    {
+        Metrics::Timer initializeTimer("sakurasuite_plugin_initialize_seconds", plugin->name());
+        PluginUsage::Scope usage(plugin);
+        plugin->initialize(m_mainWindow);
     }
+    connect(plugin->object(), SIGNAL(newDocument(DocumentBase*)), m_mainWindow, SLOT(onNewDocument(DocumentBase*)));
+    if (loader)
+        m_pluginLoaders[plugin->name().toLower()] = loader;
+    qDebug() << "Loaded plugin " << plugin->name();
+    return true;
 }
 
 void PluginsManager::onEnabledChanged()
@@ -230,9 +274,7 @@ void PluginsManager::onEnabledChanged()
     if (plugin)
     {
         MainWindow* parent = (MainWindow*)this->parent();
-        QSettings settings;
-        settings.beginGroup(plugin->name());
-        settings.setValue("enabled", plugin->enabled());
+        SettingsStore::instance()->setValue(plugin->name() + "/enabled", plugin->enabled());
         if (!plugin->enabled())
             parent->removeFileFilter(plugin->filter());
         else
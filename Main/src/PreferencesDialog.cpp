@@ -5,9 +5,9 @@
 #include "PluginsManager.hpp"
 #include "PluginInterface.hpp"
 #include "MainWindow.hpp"
+#include "SettingsStore.hpp"
 
 #include <PluginSettingsDialog.hpp>
-#include <QSettings>
 #include <QFile>
 #include <QDateTime>
 #include <QStyleFactory>
@@ -69,7 +69,7 @@ void PreferencesDialog::showEvent(QShowEvent* se)
 {
     QDialog::showEvent(se);
     ui->settingsTabView->setCurrentIndex(0);
-    QSettings settings;
+    SettingsStore* settings = SettingsStore::instance();
 
     MainWindow* mainWindow = qobject_cast<MainWindow*>(parent());
     if (mainWindow)
@@ -89,17 +89,17 @@ void PreferencesDialog::showEvent(QShowEvent* se)
         }
     }
 
-    ui->dataLineEdit->setText(settings.value(Constants::Settings::SAKURASUITE_ENGINE_DATA_PATH).toString());
-    ui->executableLineEdit->setText(settings.value(Constants::Settings::SAKURASUITE_ENGINE_EXECUTABLE).toString());
+    ui->dataLineEdit->setText(settings->value(Constants::Settings::SAKURASUITE_ENGINE_DATA_PATH).toString());
+    ui->executableLineEdit->setText(settings->value(Constants::Settings::SAKURASUITE_ENGINE_EXECUTABLE).toString());
 
-    m_currentStyle = settings.value(Constants::Settings::SAKURASUITE_CURRENT_STYLE).toString();
-    m_defaultStyle = settings.value(Constants::Settings::SAKURASUITE_DEFAULT_STYLE).toString();
+    m_currentStyle = settings->value(Constants::Settings::SAKURASUITE_CURRENT_STYLE).toString();
+    m_defaultStyle = settings->value(Constants::Settings::SAKURASUITE_DEFAULT_STYLE).toString();
 
     updateKeys();
 
-    m_singleInstance = settings.value("singleInstance").toBool();
+    m_singleInstance = settings->value<bool>(Constants::Settings::SAKURASUITE_SINGLE_INSTANCE, false);
 
-    ui->checkOnStart->setChecked(settings.value(Constants::Settings::SAKURASUITE_CHECK_ON_START, false).toBool());
+    ui->checkOnStart->setChecked(settings->value<bool>(Constants::Settings::SAKURASUITE_CHECK_ON_START, false));
 
     int index = 0;
     this->setUpdatesEnabled(false);
@@ -117,9 +117,9 @@ void PreferencesDialog::showEvent(QShowEvent* se)
         index++;
     }
 
-    ui->updateUrlLineEdit->setText(settings.value(Constants::Settings::SAKURASUITE_UPDATE_URL, Constants::Settings::SAKURASUITE_UPDATE_URL_DEFAULT).toString());
+    ui->updateUrlLineEdit->setText(settings->value<QString>(Constants::Settings::SAKURASUITE_UPDATE_URL, Constants::Settings::SAKURASUITE_UPDATE_URL_DEFAULT));
     //ui->updateUrlLineEdit->setModified(false);
-    ui->singleInstanceCheckBox->setChecked(QSettings().value("singleInstance", false).toBool());
+    ui->singleInstanceCheckBox->setChecked(m_singleInstance);
     this->setUpdatesEnabled(true);
 }
 
@@ -175,7 +175,7 @@ void PreferencesDialog::onTextChanged(QString text)
 
         // If the text matches what is currently stored
         // Set the line edit is unmodified
-        if (text == QSettings().value(Constants::Settings::SAKURASUITE_UPDATE_URL, Constants::Settings::SAKURASUITE_UPDATE_URL).toString())
+        if (text == SettingsStore::instance()->value<QString>(Constants::Settings::SAKURASUITE_UPDATE_URL, Constants::Settings::SAKURASUITE_UPDATE_URL))
             ui->updateUrlLineEdit->setModified(false);
     }
     else if (sender() == ui->executableLineEdit)
@@ -245,6 +245,24 @@ void PreferencesDialog::onLoadKeys()
     }
 }
 
+void PreferencesDialog::onLoadKeysDirectory()
+{
+    QString directory = QFileDialog::getExistingDirectory(this, "Load Keys", Constants::SAKURASUITE_HOME_PATH);
+    if (directory.isEmpty())
+        return;
+
+    int loaded = m_keyManager->openDirectory(directory);
+    ui->statusLabel->setText(QString("Loaded the keys of %1 consoles").arg(loaded));
+    updateConsoles();
+}
+
+void PreferencesDialog::onConsoleActivated(int index)
+{
+    // Every loaded console is in memory, switching doesn't read anything
+    if (m_keyManager->selectConsole(ui->consoleComboBox->itemData(index).toUInt()))
+        updateKeys();
+}
+
 void PreferencesDialog::onLoadMac()
 {
     QFileInfo finfo(qApp->applicationDirPath() + "/mac.txt");
@@ -302,13 +320,13 @@ void PreferencesDialog::onLoadMac()
 
 void PreferencesDialog::saveSettings()
 {
-    QSettings settings;
+    SettingsStore* settings = SettingsStore::instance();
 
     // Check the update url first, so we can bail out if it's invalid
     if (ui->updateUrlLineEdit->isModified() && !ui->updateUrlLineEdit->text().isEmpty())
     {
         if (ui->updateUrlLineEdit->property("valid").toBool())
-            settings.setValue(Constants::Settings::SAKURASUITE_UPDATE_URL, ui->updateUrlLineEdit->text());
+            settings->setValue(Constants::Settings::SAKURASUITE_UPDATE_URL, ui->updateUrlLineEdit->text());
         else
         {
             QMessageBox mbox(this);
@@ -324,9 +342,9 @@ void PreferencesDialog::saveSettings()
 
 
     if (m_currentChanged)
-        settings.setValue(Constants::Settings::SAKURASUITE_CURRENT_STYLE, ui->currentStyleCombo->currentText());
+        settings->setValue(Constants::Settings::SAKURASUITE_CURRENT_STYLE, ui->currentStyleCombo->currentText());
     if (m_defaultChanged)
-        settings.setValue(Constants::Settings::SAKURASUITE_DEFAULT_STYLE, ui->defaultStyleCombo->currentText());
+        settings->setValue(Constants::Settings::SAKURASUITE_DEFAULT_STYLE, ui->defaultStyleCombo->currentText());
 
     qApp->setStyle(ui->currentStyleCombo->currentText());
 
@@ -366,28 +384,15 @@ void PreferencesDialog::saveSettings()
     }
 
     m_keyManager->saveKeys();
-    settings.setValue(Constants::Settings::SAKURASUITE_CHECK_ON_START, ui->checkOnStart->isChecked());
-    settings.setValue("singleInstance", m_singleInstance);
-
-    if (m_singleInstance && !QFile::exists(Constants::SAKURASUITE_LOCK_FILE))
-    {
-        QFile file(Constants::SAKURASUITE_LOCK_FILE);
-        if (file.open(QFile::WriteOnly))
-        {
-            file.seek(0);
-            file.write(QString(QDateTime::currentDateTime().toString() + "\n").toLatin1());
-            file.resize(file.pos());
-        }
-    } else if (!m_singleInstance)
-    {
-        QFile(Constants::SAKURASUITE_LOCK_FILE).remove();
-    }
+    settings->setValue(Constants::Settings::SAKURASUITE_CHECK_ON_START, ui->checkOnStart->isChecked());
+    // The instance lock is taken at startup, so this applies from the next launch on
+    settings->setValue(Constants::Settings::SAKURASUITE_SINGLE_INSTANCE, m_singleInstance);
 
     if (ui->dataLineEdit->property("valid").toBool())
-        settings.setValue(Constants::Settings::SAKURASUITE_ENGINE_DATA_PATH, ui->dataLineEdit->text());
+        settings->setValue(Constants::Settings::SAKURASUITE_ENGINE_DATA_PATH, ui->dataLineEdit->text());
 
     if (ui->executableLineEdit->property("valid").toBool())
-        settings.setValue(Constants::Settings::SAKURASUITE_ENGINE_EXECUTABLE, ui->executableLineEdit->text());
+        settings->setValue(Constants::Settings::SAKURASUITE_ENGINE_EXECUTABLE, ui->executableLineEdit->text());
 }
 
 void PreferencesDialog::updateKeys()
@@ -398,6 +403,20 @@ void PreferencesDialog::updateKeys()
     ui->ngSigPt2LineEdit->setText(m_keyManager->ngSig().mid(30).toHex());
     ui->ngPrivLineEdit->setText(m_keyManager->ngPriv().toHex());
     ui->macAddrLineEdit->setText(m_keyManager->macAddr().toHex());
+    updateConsoles();
+}
+
+void PreferencesDialog::updateConsoles()
+{
+    ui->consoleComboBox->clear();
+    foreach (quint32 ngId, m_keyManager->consoles())
+    {
+        ui->consoleComboBox->addItem(QString("%1").arg(ngId, 8, 16, QChar('0')), ngId);
+        if (ngId == m_keyManager->ngId())
+            ui->consoleComboBox->setCurrentIndex(ui->consoleComboBox->count() - 1);
+    }
+
+    ui->consoleComboBox->setEnabled(ui->consoleComboBox->count() > 1);
 }
 
 void PreferencesDialog::restoreParents()
@@ -0,0 +1,134 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+#include "SearchDock.hpp"
+#include "ui_SearchDock.h"
+#include "MainWindow.hpp"
+#include "PluginsManager.hpp"
+#include "SearchDecoderInterface.hpp"
+
+#include <PluginInterface.hpp>
+#include <QTreeWidgetItem>
+
+SearchDock::SearchDock(MainWindow* parent) :
+    QDockWidget(parent),
+    ui(new Ui::SearchDock),
+    m_mainWindow(parent),
+    m_searchService(new SearchService(this))
+{
+    ui->setupUi(this);
+    connect(m_searchService, SIGNAL(resultsFound(QList<SearchResult>)), this, SLOT(onResultsFound(QList<SearchResult>)));
+    connect(m_searchService, SIGNAL(finished(int,int,qint64)), this, SLOT(onFinished(int,int,qint64)));
+}
+
+SearchDock::~SearchDock()
+{
+    delete m_searchService;
+    m_searchService = NULL;
+    delete ui;
+    ui = NULL;
+}
+
+void SearchDock::focusPattern()
+{
+    ui->patternLineEdit->setFocus();
+    ui->patternLineEdit->selectAll();
+}
+
+void SearchDock::onSearch()
+{
+    if (m_searchService->isRunning())
+    {
+        m_searchService->cancel();
+        return;
+    }
+
+    QByteArray pattern;
+    if (ui->hexCheckBox->isChecked())
+        pattern = QByteArray::fromHex(ui->patternLineEdit->text().remove(' ').toLatin1());
+    else
+        pattern = ui->patternLineEdit->text().toUtf8();
+
+    if (pattern.isEmpty())
+        return;
+
+    QDir dataPath = m_mainWindow->engineDataPath();
+    if (dataPath.path().isEmpty() || !dataPath.exists())
+    {
+        ui->statusLabel->setText(tr("Engine data path is not set, please set it in Edit->Preferences"));
+        return;
+    }
+
+    QList<SearchDecoderInterface*> decoders;
+    foreach (PluginInterface* plugin, m_mainWindow->pluginsManager()->plugins())
+    {
+        SearchDecoderInterface* decoder = qobject_cast<SearchDecoderInterface*>(plugin->object());
+        if (decoder && plugin->enabled())
+            decoders.append(decoder);
+    }
+
+    ui->resultsTreeWidget->clear();
+    m_fileItems.clear();
+    ui->statusLabel->setText(tr("Searching %1...").arg(dataPath.absolutePath()));
+    ui->searchPushButton->setText(tr("&Stop"));
+    m_searchService->start(dataPath, pattern, decoders);
+}
+
+void SearchDock::onResultsFound(QList<SearchResult> results)
+{
+    QDir dataPath = m_mainWindow->engineDataPath();
+
+    ui->resultsTreeWidget->setUpdatesEnabled(false);
+    foreach (const SearchResult& result, results)
+    {
+        QTreeWidgetItem* fileItem = m_fileItems.value(result.filePath);
+        if (!fileItem)
+        {
+            fileItem = new QTreeWidgetItem(ui->resultsTreeWidget);
+            fileItem->setText(FileColumn, dataPath.relativeFilePath(result.filePath));
+            fileItem->setToolTip(FileColumn, result.filePath);
+            fileItem->setData(FileColumn, Qt::UserRole, result.filePath);
+            m_fileItems[result.filePath] = fileItem;
+        }
+
+        QTreeWidgetItem* item = new QTreeWidgetItem(fileItem);
+        item->setText(OffsetColumn, QString("0x%1%2").arg(result.offset, 8, 16, QChar('0')).arg(result.decoded ? "*" : ""));
+        item->setText(PreviewColumn, result.preview);
+        item->setData(FileColumn, Qt::UserRole, result.filePath);
+        fileItem->setText(OffsetColumn, tr("%n match(es)", "", fileItem->childCount()));
+    }
+    ui->resultsTreeWidget->setUpdatesEnabled(true);
+}
+
+void SearchDock::onFinished(int filesSearched, int matches, qint64 elapsed)
+{
+    ui->searchPushButton->setText(tr("&Find"));
+    ui->statusLabel->setText(tr("%1 match(es) in %2 file(s), searched %3 file(s) in %4 seconds")
+                             .arg(matches)
+                             .arg(m_fileItems.count())
+                             .arg(filesSearched)
+                             .arg(elapsed / 1000.0, 0, 'f', 2));
+    ui->resultsTreeWidget->resizeColumnToContents(FileColumn);
+    ui->resultsTreeWidget->resizeColumnToContents(OffsetColumn);
+}
+
+void SearchDock::onItemActivated(QTreeWidgetItem* item, int column)
+{
+    Q_UNUSED(column);
+    if (!item)
+        return;
+
+    emit openRequested(item->data(FileColumn, Qt::UserRole).toString());
+}
@@ -0,0 +1,329 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+#include "SearchService.hpp"
+#include "SearchDecoderInterface.hpp"
+
+#include <QAtomicInt>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QRunnable>
+#include <string.h>
+
+namespace
+{
+const int MaxResultsPerFile = 256;
+const int PreviewBefore     = 16;
+const int PreviewAfter      = 48;
+
+// Boyer-Moore-Horspool for longer patterns, short patterns are anchored
+// on their first byte with memchr which the C library vectorizes for us.
+class Matcher
+{
+public:
+    explicit Matcher(const QByteArray& pattern)
+        : m_pattern(pattern)
+    {
+        const int length = m_pattern.size();
+        for (int i = 0; i < 256; i++)
+            m_skip[i] = length;
+
+        const uchar* needle = (const uchar*)m_pattern.constData();
+        for (int i = 0; i < length - 1; i++)
+            m_skip[needle[i]] = length - 1 - i;
+    }
+
+    int length() const
+    {
+        return m_pattern.size();
+    }
+
+    qint64 indexIn(const uchar* data, qint64 size, qint64 from) const
+    {
+        const qint64 length = m_pattern.size();
+        if (length == 0 || size - from < length)
+            return -1;
+
+        const uchar* needle = (const uchar*)m_pattern.constData();
+        const qint64 end = size - length;
+
+        if (length < 4)
+        {
+            qint64 pos = from;
+            while (pos <= end)
+            {
+                const uchar* hit = (const uchar*)memchr(data + pos, needle[0], end - pos + 1);
+                if (!hit)
+                    return -1;
+
+                pos = hit - data;
+                if (!memcmp(hit + 1, needle + 1, length - 1))
+                    return pos;
+                pos++;
+            }
+            return -1;
+        }
+
+        const uchar last = needle[length - 1];
+        qint64 pos = from;
+        while (pos <= end)
+        {
+            const uchar c = data[pos + length - 1];
+            if (c == last && !memcmp(data + pos, needle, length - 1))
+                return pos;
+            pos += m_skip[c];
+        }
+
+        return -1;
+    }
+
+private:
+    QByteArray m_pattern;
+    qint64     m_skip[256];
+};
+
+QString makePreview(const uchar* data, qint64 size, qint64 offset, int length)
+{
+    const qint64 begin = qMax<qint64>(0, offset - PreviewBefore);
+    const qint64 end   = qMin<qint64>(size, offset + length + PreviewAfter);
+
+    QString preview;
+    preview.reserve(end - begin);
+    for (qint64 i = begin; i < end; i++)
+        preview += ((data[i] >= 0x20 && data[i] < 0x7F) ? QChar(data[i]) : QChar('.'));
+
+    return preview;
+}
+}
+
+struct SearchJob
+{
+    SearchJob(SearchService* service, quint32 generation, const QByteArray& pattern,
+              const QList<SearchDecoderInterface*>& decoders)
+        : service(service),
+          generation(generation),
+          matcher(pattern),
+          decoders(decoders),
+          pending(1)
+    {
+        timer.start();
+    }
+
+    // Every queued file holds a reference, the directory walker holds the first one.
+    // Whoever drops the last reference reports the job as finished.
+    void release()
+    {
+        if (!pending.deref())
+        {
+            QMetaObject::invokeMethod(service, "onJobFinished", Qt::QueuedConnection,
+                                      Q_ARG(quint32, generation),
+                                      Q_ARG(int, files.load()),
+                                      Q_ARG(int, matches.load()),
+                                      Q_ARG(qint64, timer.elapsed()));
+        }
+    }
+
+    SearchService*                  service;
+    quint32                         generation;
+    Matcher                         matcher;
+    QList<SearchDecoderInterface*>  decoders;
+    QElapsedTimer                   timer;
+    QAtomicInt                      cancelled;
+    QAtomicInt                      pending;
+    QAtomicInt                      files;
+    QAtomicInt                      matches;
+};
+
+namespace
+{
+class FileTask : public QRunnable
+{
+public:
+    FileTask(const QSharedPointer<SearchJob>& job, const QString& filePath)
+        : m_job(job),
+          m_filePath(filePath)
+    {
+    }
+
+    void run()
+    {
+        if (!m_job->cancelled.load())
+            search();
+
+        m_job->release();
+    }
+
+private:
+    void search()
+    {
+        QByteArray contents;
+        bool decoded = false;
+        foreach (SearchDecoderInterface* decoder, m_job->decoders)
+        {
+            if (decoder->canDecode(m_filePath))
+            {
+                contents = decoder->decode(m_filePath);
+                decoded = !contents.isEmpty();
+                if (decoded)
+                    break;
+            }
+        }
+
+        QFile file(m_filePath);
+        const uchar* data = NULL;
+        qint64 size = 0;
+
+        if (decoded)
+        {
+            data = (const uchar*)contents.constData();
+            size = contents.size();
+        }
+        else
+        {
+            if (!file.open(QFile::ReadOnly))
+                return;
+
+            size = file.size();
+            if (size < m_job->matcher.length())
+                return;
+
+            data = file.map(0, size);
+            if (!data)
+            {
+                // Some filesystems refuse to map, fall back to a plain read
+                contents = file.readAll();
+                data = (const uchar*)contents.constData();
+                size = contents.size();
+            }
+        }
+
+        m_job->files.ref();
+
+        QList<SearchResult> results;
+        qint64 pos = m_job->matcher.indexIn(data, size, 0);
+        while (pos != -1 && results.size() < MaxResultsPerFile && !m_job->cancelled.load())
+        {
+            SearchResult result;
+            result.filePath = m_filePath;
+            result.offset   = pos;
+            result.preview  = makePreview(data, size, pos, m_job->matcher.length());
+            result.decoded  = decoded;
+            results.append(result);
+
+            pos = m_job->matcher.indexIn(data, size, pos + 1);
+        }
+
+        if (results.isEmpty())
+            return;
+
+        m_job->matches.fetchAndAddRelaxed(results.size());
+        QMetaObject::invokeMethod(m_job->service, "onResults", Qt::QueuedConnection,
+                                  Q_ARG(quint32, m_job->generation),
+                                  Q_ARG(QList<SearchResult>, results));
+    }
+
+    QSharedPointer<SearchJob> m_job;
+    QString                   m_filePath;
+};
+
+class WalkTask : public QRunnable
+{
+public:
+    WalkTask(const QSharedPointer<SearchJob>& job, QThreadPool* pool, const QString& root)
+        : m_job(job),
+          m_pool(pool),
+          m_root(root)
+    {
+    }
+
+    void run()
+    {
+        QDirIterator it(m_root, QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+        while (it.hasNext() && !m_job->cancelled.load())
+        {
+            m_job->pending.ref();
+            m_pool->start(new FileTask(m_job, it.next()));
+        }
+
+        m_job->release();
+    }
+
+private:
+    QSharedPointer<SearchJob> m_job;
+    QThreadPool*              m_pool;
+    QString                   m_root;
+};
+}
+
+SearchService::SearchService(QObject* parent)
+    : QObject(parent),
+      m_generation(0)
+{
+    qRegisterMetaType<SearchResult>("SearchResult");
+    qRegisterMetaType<QList<SearchResult> >("QList<SearchResult>");
+}
+
+SearchService::~SearchService()
+{
+    cancel();
+    m_pool.waitForDone();
+}
+
+bool SearchService::isRunning() const
+{
+    return !m_job.isNull();
+}
+
+void SearchService::start(const QDir& root, const QByteArray& pattern, const QList<SearchDecoderInterface*>& decoders)
+{
+    cancel();
+
+    if (pattern.isEmpty() || !root.exists())
+    {
+        emit finished(0, 0, 0);
+        return;
+    }
+
+    m_job = QSharedPointer<SearchJob>(new SearchJob(this, ++m_generation, pattern, decoders));
+    m_pool.start(new WalkTask(m_job, &m_pool, root.absolutePath()));
+}
+
+void SearchService::cancel()
+{
+    if (m_job.isNull())
+        return;
+
+    m_job->cancelled.store(1);
+    m_job.clear();
+}
+
+void SearchService::onResults(quint32 generation, QList<SearchResult> results)
+{
+    // Results from a cancelled or superseded search are dropped
+    if (generation != m_generation || m_job.isNull())
+        return;
+
+    emit resultsFound(results);
+}
+
+void SearchService::onJobFinished(quint32 generation, int filesSearched, int matches, qint64 elapsed)
+{
+    if (generation != m_generation)
+        return;
+
+    m_job.clear();
+    emit finished(filesSearched, matches, elapsed);
+}
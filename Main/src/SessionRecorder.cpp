@@ -0,0 +1,166 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+
+#include "SessionRecorder.hpp"
+#include "Constants.hpp"
+#include <DocumentBase.hpp>
+#include <QCoreApplication>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QDebug>
+
+SessionRecorder* SessionRecorder::m_instance = NULL;
+
+SessionRecorder* SessionRecorder::instance()
+{
+    if (!m_instance)
+        m_instance = new SessionRecorder;
+
+    return m_instance;
+}
+
+SessionRecorder::SessionRecorder()
+    : QObject(qApp),
+      m_relative(false),
+      m_edits(0),
+      m_editStart(0)
+{
+    m_editTimer.setSingleShot(true);
+    m_editTimer.setInterval(BurstGap);
+    connect(&m_editTimer, SIGNAL(timeout()), this, SLOT(flushEdits()));
+}
+
+SessionRecorder::~SessionRecorder()
+{
+    stop();
+    m_instance = NULL;
+}
+
+bool SessionRecorder::start(const QString& fileName, const QString& basePath)
+{
+    stop();
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QFile::WriteOnly | QFile::Truncate | QFile::Text))
+    {
+        qWarning() << "Unable to record the session to" << fileName << m_file.errorString();
+        return false;
+    }
+
+    m_base = QDir(basePath);
+    m_relative = !basePath.isEmpty() && m_base.exists();
+    m_current.clear();
+    m_clock.start();
+    write(0, "session", QString());
+    qDebug() << "Recording the session to" << fileName;
+    return true;
+}
+
+void SessionRecorder::stop()
+{
+    if (!m_file.isOpen())
+        return;
+
+    flushEdits();
+    m_file.close();
+}
+
+bool SessionRecorder::isRecording() const
+{
+    return m_file.isOpen();
+}
+
+void SessionRecorder::record(const QString& action, const QString& file, const QString& to)
+{
+    if (!m_file.isOpen())
+        return;
+
+    // Opening a file also makes it the current one, that's no extra switch
+    if (action == "switch" && file == m_current)
+        return;
+
+    flushEdits();
+    write(m_clock.elapsed(), action, file, 0, to);
+
+    if (action == "open" || action == "switch")
+        m_current = file;
+    else if (action == "saveAs" && file == m_current)
+        m_current = to;
+    else if (action == "close" && file == m_current)
+        m_current.clear();
+}
+
+void SessionRecorder::watch(DocumentBase* document)
+{
+    if (m_file.isOpen() && document)
+        connect(document, SIGNAL(modified()), this, SLOT(onModified()), Qt::UniqueConnection);
+}
+
+void SessionRecorder::onModified()
+{
+    DocumentBase* document = qobject_cast<DocumentBase*>(sender());
+    if (!m_file.isOpen() || !document)
+        return;
+
+    QString file = document->filePath();
+    if (file != m_editFile)
+    {
+        flushEdits();
+        m_editFile = file;
+        m_editStart = m_clock.elapsed();
+    }
+
+    m_edits++;
+    m_editTimer.start();
+}
+
+void SessionRecorder::flushEdits()
+{
+    m_editTimer.stop();
+    if (!m_edits)
+        return;
+
+    write(m_editStart, "edit", m_editFile, m_edits);
+    m_edits = 0;
+    m_editFile.clear();
+}
+
+void SessionRecorder::write(qint64 time, const QString& action, const QString& file, int count, const QString& to)
+{
+    QJsonObject object;
+    object["t"] = (double)time;
+    object["action"] = action;
+    if (!file.isEmpty())
+        object["file"] = scriptPath(file);
+    if (!to.isEmpty())
+        object["to"] = scriptPath(to);
+    if (count)
+        object["count"] = count;
+    if (action == "session")
+        object["version"] = Constants::SAKURASUITE_APP_VERSION;
+
+    m_file.write(QJsonDocument(object).toJson(QJsonDocument::Compact));
+    m_file.write("\n");
+    m_file.flush();
+}
+
+QString SessionRecorder::scriptPath(const QString& file) const
+{
+    // Relative paths let a script be replayed against another copy of the data
+    QString path = QDir::cleanPath(QDir::fromNativeSeparators(file));
+    QString relative = m_base.relativeFilePath(path);
+    return (m_relative && !relative.startsWith("..")) ? relative : path;
+}
@@ -0,0 +1,129 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+#include "SettingsStore.hpp"
+#include "AllocationProfiler.hpp"
+#include <QCoreApplication>
+#include <QSettings>
+
+SettingsStore* SettingsStore::m_instance = NULL;
+
+SettingsStore::SettingsStore()
+    : QObject(qApp)
+{
+    QSettings settings;
+    foreach (const QString& key, settings.allKeys())
+        m_values[key] = settings.value(key);
+
+    // Writes are flushed at most every two seconds
+    m_syncTimer.setSingleShot(true);
+    m_syncTimer.setInterval(2000);
+    connect(&m_syncTimer, SIGNAL(timeout()), this, SLOT(sync()));
+    connect(qApp, SIGNAL(aboutToQuit()), this, SLOT(sync()));
+}
+
+SettingsStore::~SettingsStore()
+{
+    sync();
+    m_instance = NULL;
+}
+
+SettingsStore* SettingsStore::instance()
+{
+    if (!m_instance)
+        m_instance = new SettingsStore;
+    return m_instance;
+}
+
+QVariant SettingsStore::value(const QString& key, const QVariant& defaultValue) const
+{
+    AllocationProfiler::Scope allocations("settings");
+    QReadLocker locker(&m_lock);
+    QHash<QString, QVariant>::const_iterator it = m_values.constFind(key);
+    if (it == m_values.constEnd() || !it.value().isValid())
+        return defaultValue;
+
+    return it.value();
+}
+
+void SettingsStore::setValue(const QString& key, const QVariant& value)
+{
+    AllocationProfiler::Scope allocations("settings");
+    {
+        QWriteLocker locker(&m_lock);
+        QHash<QString, QVariant>::iterator it = m_values.find(key);
+        if (it != m_values.end() && it.value() == value && it.value().isValid() == value.isValid())
+            return;
+
+        m_values[key] = value;
+        m_dirty.insert(key);
+    }
+
+    // The timer lives on the GUI thread
+    QMetaObject::invokeMethod(&m_syncTimer, "start", Qt::AutoConnection);
+    emit valueChanged(key, value);
+}
+
+void SettingsStore::remove(const QString& key)
+{
+    // An invalid value marks the key for removal from the backend on the next sync
+    setValue(key, QVariant());
+}
+
+bool SettingsStore::contains(const QString& key) const
+{
+    QReadLocker locker(&m_lock);
+    return m_values.value(key).isValid();
+}
+
+QStringList SettingsStore::allKeys() const
+{
+    QReadLocker locker(&m_lock);
+    QStringList keys;
+    QHash<QString, QVariant>::const_iterator it = m_values.constBegin();
+    for (; it != m_values.constEnd(); ++it)
+    {
+        if (it.value().isValid())
+            keys << it.key();
+    }
+
+    return keys;
+}
+
+void SettingsStore::sync()
+{
+    m_syncTimer.stop();
+    AllocationProfiler::Scope allocations("settings");
+
+    QWriteLocker locker(&m_lock);
+    if (m_dirty.isEmpty())
+        return;
+
+    QSettings settings;
+    foreach (const QString& key, m_dirty)
+    {
+        const QVariant& value = m_values[key];
+        if (value.isValid())
+            settings.setValue(key, value);
+        else
+        {
+            settings.remove(key);
+            m_values.remove(key);
+        }
+    }
+
+    m_dirty.clear();
+    settings.sync();
+}
@@ -0,0 +1,138 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+#include "SingleInstance.hpp"
+#include "Constants.hpp"
+
+#include <QDataStream>
+#include <QFileInfo>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QThread>
+#include <QDebug>
+
+namespace
+{
+// The running instance may still be starting up when we get here,
+// so give it a short while to start listening.
+const int ConnectAttempts = 20;
+const int ConnectTimeout  = 100;
+}
+
+SingleInstance::SingleInstance()
+    : m_lockFile(Constants::SAKURASUITE_LOCK_FILE),
+      m_server(NULL)
+{
+#ifdef Q_OS_WIN
+    QString user = QString::fromLocal8Bit(qgetenv("USERNAME"));
+#else
+    QString user = QString::fromLocal8Bit(qgetenv("USER"));
+#endif
+    m_serverName = QString("sakurasuite-%1").arg(user);
+
+    // The lock is only ever stale if its owner died, never because of its age
+    m_lockFile.setStaleLockTime(0);
+}
+
+SingleInstance::~SingleInstance()
+{
+    if (m_server)
+        m_server->close();
+    m_lockFile.unlock();
+}
+
+bool SingleInstance::tryLock()
+{
+    return m_lockFile.tryLock(0);
+}
+
+bool SingleInstance::forward(const QStringList& files)
+{
+    QStringList absoluteFiles;
+    foreach (const QString& file, files)
+        absoluteFiles << QFileInfo(file).absoluteFilePath();
+
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out << absoluteFiles;
+
+    QLocalSocket socket;
+    for (int i = 0; i < ConnectAttempts; i++)
+    {
+        socket.connectToServer(m_serverName);
+        if (socket.waitForConnected(ConnectTimeout))
+        {
+            socket.write(data);
+            bool written = socket.waitForBytesWritten(ConnectTimeout);
+            socket.disconnectFromServer();
+            if (socket.state() != QLocalSocket::UnconnectedState)
+                socket.waitForDisconnected(ConnectTimeout);
+            return written;
+        }
+
+        QThread::msleep(ConnectTimeout);
+    }
+
+    return false;
+}
+
+bool SingleInstance::listen()
+{
+    if (m_server)
+        return true;
+
+    m_server = new QLocalServer(this);
+    m_server->setSocketOptions(QLocalServer::UserAccessOption);
+    connect(m_server, SIGNAL(newConnection()), this, SLOT(onNewConnection()));
+
+    // We hold the lock, so any socket left behind belongs to a dead instance
+    QLocalServer::removeServer(m_serverName);
+    if (!m_server->listen(m_serverName))
+    {
+        qWarning() << "Unable to listen for other instances:" << m_server->errorString();
+        return false;
+    }
+
+    return true;
+}
+
+void SingleInstance::onNewConnection()
+{
+    while (QLocalSocket* socket = m_server->nextPendingConnection())
+    {
+        // A fast client may already be gone, its data is still buffered
+        if (socket->state() == QLocalSocket::UnconnectedState)
+            readFiles(socket);
+        else
+            connect(socket, SIGNAL(disconnected()), this, SLOT(onDisconnected()));
+    }
+}
+
+void SingleInstance::onDisconnected()
+{
+    QLocalSocket* socket = qobject_cast<QLocalSocket*>(sender());
+    if (socket)
+        readFiles(socket);
+}
+
+void SingleInstance::readFiles(QLocalSocket* socket)
+{
+    QDataStream in(socket->readAll());
+    QStringList files;
+    in >> files;
+    socket->deleteLater();
+
+    emit filesReceived(files);
+}
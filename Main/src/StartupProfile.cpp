@@ -0,0 +1,113 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+
+#include "StartupProfile.hpp"
+#include <QAbstractEventDispatcher>
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QDebug>
+#include <chrono>
+
+StartupProfile* StartupProfile::m_instance = NULL;
+
+StartupProfile::StartupProfile()
+    : QObject(qApp),
+      m_fileName(QString::fromLocal8Bit(qgetenv("SAKURASUITE_STARTUP_PROFILE")))
+{
+}
+
+StartupProfile::~StartupProfile()
+{
+    m_instance = NULL;
+}
+
+StartupProfile* StartupProfile::instance()
+{
+    if (!m_instance)
+        m_instance = new StartupProfile;
+    return m_instance;
+}
+
+bool StartupProfile::isEnabled() const
+{
+    return !m_fileName.isEmpty();
+}
+
+qint64 StartupProfile::now()
+{
+    // CLOCK_MONOTONIC and QueryPerformanceCounter are system wide
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void StartupProfile::mark(const QString& milestone, qint64 time)
+{
+    if (!isEnabled())
+        return;
+
+    // Only the first time a milestone is reached counts
+    for (int i = 0; i < m_marks.count(); i++)
+    {
+        if (m_marks.at(i).first == milestone)
+            return;
+    }
+
+    m_marks << qMakePair(milestone, time);
+}
+
+void StartupProfile::finishOnIdle()
+{
+    if (!isEnabled())
+        return;
+
+    // Fired when the loop is about to wait for events, by then everything
+    // startup posted or queued has run and the first paint has happened
+    connect(QAbstractEventDispatcher::instance(), SIGNAL(aboutToBlock()), this, SLOT(onAboutToBlock()));
+}
+
+void StartupProfile::onAboutToBlock()
+{
+    disconnect(QAbstractEventDispatcher::instance(), SIGNAL(aboutToBlock()), this, SLOT(onAboutToBlock()));
+    mark("firstIdle");
+
+    QString error;
+    if (!write(&error))
+        qWarning() << "Unable to write startup profile" << m_fileName << error;
+
+    qApp->quit();
+}
+
+bool StartupProfile::write(QString* error)
+{
+    QJsonObject marks;
+    for (int i = 0; i < m_marks.count(); i++)
+        marks[m_marks.at(i).first] = (double)m_marks.at(i).second;
+
+    QJsonObject profile;
+    profile["pid"] = (double)QCoreApplication::applicationPid();
+    profile["marks"] = marks;
+
+    QFile file(m_fileName);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate) || file.write(QJsonDocument(profile).toJson()) < 0)
+    {
+        if (error)
+            *error = file.errorString();
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,359 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+
+#include "Tracer.hpp"
+#include "Constants.hpp"
+#include <QCoreApplication>
+#include <QFile>
+#include <QThread>
+#include <QDebug>
+#include <string.h>
+
+namespace
+{
+void appendString(QByteArray& out, const QByteArray& string)
+{
+    out += '"';
+    for (int i = 0; i < string.size(); i++)
+    {
+        char c = string.at(i);
+        switch (c)
+        {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n";  break;
+            case '\r': out += "\\r";  break;
+            case '\t': out += "\\t";  break;
+            default:
+                if ((uchar)c < 0x20)
+                    out += QByteArray("\\u00") + QByteArray::number((uchar)c, 16).rightJustified(2, '0');
+                else
+                    out += c;
+                break;
+        }
+    }
+    out += '"';
+}
+
+// Trace timestamps are microseconds, nanoseconds are kept as the fraction
+void appendTimestamp(QByteArray& out, qint64 nsecs)
+{
+    out += QByteArray::number(nsecs / 1000);
+    out += '.';
+    out += QByteArray::number(nsecs % 1000).rightJustified(3, '0');
+}
+
+// Flushed to the file in chunks so a large trace doesn't have to fit in memory twice
+const int WriteChunk = 1 << 20;
+
+// Spans this thread began while tracing was on and hasn't ended, so end()
+// can return without touching the buffer when there is nothing to end
+thread_local int beganSpans = 0;
+}
+
+Tracer* Tracer::m_instance = NULL;
+
+Tracer* Tracer::instance()
+{
+    if (!m_instance)
+        m_instance = new Tracer;
+
+    return m_instance;
+}
+
+Tracer::Tracer()
+    : QObject(qApp)
+{
+    m_clock.start();
+}
+
+Tracer::~Tracer()
+{
+    qDeleteAll(m_buffers);
+    m_instance = NULL;
+}
+
+void Tracer::setEnabled(bool enabled)
+{
+    m_enabled.store(enabled ? 1 : 0);
+}
+
+void Tracer::clear()
+{
+    QMutexLocker locker(&m_buffersMutex);
+    foreach (ThreadBuffer* buffer, m_buffers)
+    {
+        QMutexLocker bufferLocker(&buffer->mutex);
+        buffer->events.clear();
+        buffer->dropped = 0;
+        // Otherwise the ends of spans begun after the clear would be swallowed
+        buffer->droppedDepth = 0;
+        buffer->depth = 0;
+    }
+}
+
+Tracer::ThreadBuffer* Tracer::buffer()
+{
+    static thread_local ThreadBuffer* current = NULL;
+    if (current)
+        return current;
+
+    ThreadBuffer* buffer = new ThreadBuffer;
+    buffer->dropped = 0;
+    buffer->droppedDepth = 0;
+    buffer->depth = 0;
+    buffer->names.append(QByteArray());
+
+    QThread* thread = QThread::currentThread();
+    buffer->thread = thread;
+    if (qApp && thread == qApp->thread())
+        buffer->name = "Main";
+    else
+        buffer->name = thread->objectName();
+
+    QMutexLocker locker(&m_buffersMutex);
+    buffer->id = m_buffers.size() + 1;
+    if (buffer->name.isEmpty())
+        buffer->name = QString("Thread %1").arg(buffer->id);
+    m_buffers.append(buffer);
+    current = buffer;
+    return buffer;
+}
+
+quint32 Tracer::intern(ThreadBuffer* buffer, const char* name)
+{
+    if (!name || !*name)
+        return 0;
+
+    // A plugin may be unloaded and another string mapped at the same
+    // address, so the contents are verified
+    QHash<const char*, quint32>::const_iterator it = buffer->byAddress.constFind(name);
+    if (it != buffer->byAddress.constEnd() && !strcmp(buffer->names.at(it.value()).constData(), name))
+        return it.value();
+
+    QByteArray string(name);
+    quint32 index = buffer->byName.value(string, 0);
+    if (!index)
+    {
+        index = buffer->names.size();
+        buffer->names.append(string);
+        buffer->byName.insert(string, index);
+    }
+
+    buffer->byAddress.insert(name, index);
+    return index;
+}
+
+void Tracer::record(char phase, const char* category, const char* name, qint64 value)
+{
+    ThreadBuffer* buffer = this->buffer();
+    Event event;
+    event.timestamp = m_clock.nsecsElapsed();
+    event.value = value;
+    event.phase = phase;
+
+    QMutexLocker locker(&buffer->mutex);
+    // Once full, spans that begin are dropped along with their end, but
+    // spans that were already recorded still get to end
+    if (phase == 'E' && buffer->droppedDepth > 0)
+    {
+        buffer->droppedDepth--;
+        return;
+    }
+
+    // Only ends spans that were recorded, those begun before a clear() are gone
+    if (phase == 'E')
+    {
+        if (buffer->depth == 0)
+            return;
+        buffer->depth--;
+    }
+
+    if (phase != 'E' && buffer->events.size() >= MaxEventsPerThread)
+    {
+        buffer->dropped++;
+        if (phase == 'B')
+            buffer->droppedDepth++;
+        return;
+    }
+
+    if (phase == 'B')
+        buffer->depth++;
+
+    event.category = intern(buffer, category);
+    event.name = intern(buffer, name);
+    buffer->events.append(event);
+}
+
+void Tracer::begin(const char* category, const char* name)
+{
+    if (isEnabled())
+    {
+        beganSpans++;
+        record('B', category, name, 0);
+    }
+}
+
+void Tracer::begin(const QString& category, const QString& name)
+{
+    if (isEnabled())
+    {
+        beganSpans++;
+        record('B', category.toUtf8().constData(), name.toUtf8().constData(), 0);
+    }
+}
+
+void Tracer::end()
+{
+    // Recorded even if tracing was turned off inside the span, but only
+    // for spans begun while it was on
+    if (beganSpans == 0)
+        return;
+
+    beganSpans--;
+    record('E', NULL, NULL, 0);
+}
+
+void Tracer::counter(const char* name, qint64 value)
+{
+    if (isEnabled())
+        record('C', NULL, name, value);
+}
+
+void Tracer::setThreadName(const QString& name)
+{
+    ThreadBuffer* buffer = this->buffer();
+    QMutexLocker locker(&buffer->mutex);
+    buffer->name = name;
+}
+
+QStringList Tracer::openSpans(QThread* thread)
+{
+    QStringList spans;
+    QMutexLocker locker(&m_buffersMutex);
+    foreach (ThreadBuffer* buffer, m_buffers)
+    {
+        if (buffer->thread != thread)
+            continue;
+
+        // Walk back from the newest event skipping spans that have ended
+        QMutexLocker bufferLocker(&buffer->mutex);
+        int ended = 0;
+        for (int i = buffer->events.size() - 1; i >= 0; i--)
+        {
+            const Event& event = buffer->events.at(i);
+            if (event.phase == 'E')
+                ended++;
+            else if (event.phase == 'B' && ended > 0)
+                ended--;
+            else if (event.phase == 'B')
+                spans.prepend(QString::fromUtf8(buffer->names.at(event.name)));
+        }
+    }
+
+    return spans;
+}
+
+bool Tracer::save(const QString& fileName, QString* error)
+{
+    QFile file(fileName);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate))
+    {
+        if (error)
+            *error = file.errorString();
+        return false;
+    }
+
+    QList<ThreadBuffer*> buffers;
+    {
+        QMutexLocker locker(&m_buffersMutex);
+        buffers = m_buffers;
+    }
+
+    const QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+    QByteArray out;
+    out.reserve(WriteChunk + 4096);
+    out += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out += "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":" + pid + ",\"tid\":0,\"args\":{\"name\":";
+    appendString(out, Constants::SAKURASUITE_TITLE.toUtf8());
+    out += "}}";
+
+    quint64 dropped = 0;
+    foreach (ThreadBuffer* buffer, buffers)
+    {
+        // Copied so the thread can keep recording while the file is written
+        QVector<Event> events;
+        QList<QByteArray> names;
+        QString threadName;
+        {
+            QMutexLocker locker(&buffer->mutex);
+            events = buffer->events;
+            names = buffer->names;
+            threadName = buffer->name;
+            dropped += buffer->dropped;
+        }
+
+        const QByteArray tid = QByteArray::number(buffer->id);
+        out += ",\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" + pid + ",\"tid\":" + tid + ",\"args\":{\"name\":";
+        appendString(out, threadName.toUtf8());
+        out += "}}";
+
+        foreach (const Event& event, events)
+        {
+            out += ",\n{\"ph\":\"";
+            out += event.phase;
+            out += "\",\"pid\":" + pid + ",\"tid\":" + tid + ",\"ts\":";
+            appendTimestamp(out, event.timestamp);
+            if (event.phase != 'E')
+            {
+                out += ",\"name\":";
+                appendString(out, names.at(event.name));
+            }
+            if (event.category)
+            {
+                out += ",\"cat\":";
+                appendString(out, names.at(event.category));
+            }
+            if (event.phase == 'C')
+            {
+                out += ",\"args\":{\"value\":";
+                out += QByteArray::number(event.value);
+                out += '}';
+            }
+            out += '}';
+
+            if (out.size() >= WriteChunk)
+            {
+                file.write(out);
+                out.clear();
+            }
+        }
+    }
+
+    out += "\n]}\n";
+    file.write(out);
+    if (dropped)
+        qWarning() << "Trace buffers were full," << dropped << "events were dropped";
+
+    if (file.error() != QFile::NoError)
+    {
+        if (error)
+            *error = file.errorString();
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,308 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+
+#include "Watchdog.hpp"
+#include "Tracer.hpp"
+#include "SettingsStore.hpp"
+#include "Constants.hpp"
+#include <QCoreApplication>
+#include <QEvent>
+#include <QMetaEnum>
+#include <QDebug>
+
+#if defined(Q_OS_LINUX) || defined(Q_OS_MAC)
+#define SS_WATCHDOG_STACKS
+#include <execinfo.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#endif
+
+namespace
+{
+#ifdef SS_WATCHDOG_STACKS
+// The GUI thread is interrupted with this signal and walks its own stack
+const int StackSignal = SIGUSR2;
+// How long to wait for the GUI thread to run the signal handler
+const int StackTimeout = 100;
+
+// A request that timed out may still be answered later, the states make sure
+// the handler and the watchdog never use the frames at the same time
+enum StackState
+{
+    StackIdle,
+    StackRequested,
+    StackWalking,
+    StackDone
+};
+
+pthread_t        s_guiThread;
+bool             s_stackHandlerInstalled = false;
+struct sigaction s_previousAction;
+void*            s_frames[Watchdog::MaxFrames];
+int              s_frameCount;
+QAtomicInt       s_stackState(StackIdle);
+
+void stackSignalHandler(int)
+{
+    // Nobody is waiting anymore, or the signal didn't come from us
+    if (!s_stackState.testAndSetAcquire(StackRequested, StackWalking))
+        return;
+
+    s_frameCount = backtrace(s_frames, Watchdog::MaxFrames);
+    s_stackState.storeRelease(StackDone);
+}
+#endif
+
+QString eventName(int type)
+{
+    static const int index = QEvent::staticMetaObject.indexOfEnumerator("Type");
+    const char* name = QEvent::staticMetaObject.enumerator(index).valueToKey(type);
+    return name ? QString(name) : QString::number(type);
+}
+}
+
+QAtomicPointer<Watchdog> Watchdog::m_instance;
+
+Watchdog* Watchdog::instance()
+{
+    Watchdog* watchdog = m_instance.loadAcquire();
+    if (!watchdog)
+    {
+        watchdog = new Watchdog;
+        m_instance.storeRelease(watchdog);
+    }
+
+    return watchdog;
+}
+
+Watchdog::Watchdog()
+    : QThread(qApp),
+      m_heartbeat(0),
+      m_receiver(NULL),
+      m_eventType(QEvent::None),
+      m_stop(false)
+{
+    setObjectName("Watchdog");
+    m_clock.start();
+    m_threshold.store(SettingsStore::instance()->value<int>(Constants::Settings::SAKURASUITE_STALL_THRESHOLD, DefaultThreshold));
+    // Looked up here, the registry isn't safe to create from another thread
+    m_stalls = Metrics::instance()->counter("sakurasuite_gui_stalls_total");
+    m_stallTimes = Metrics::instance()->histogram("sakurasuite_gui_stall_seconds");
+
+#ifdef SS_WATCHDOG_STACKS
+    s_guiThread = pthread_self();
+    // backtrace() loads libgcc the first time, which isn't safe in a signal handler
+    void* frame;
+    backtrace(&frame, 1);
+
+    // Leave the signal alone if something else in the process already handles it
+    struct sigaction action;
+    if (sigaction(StackSignal, NULL, &s_previousAction) == 0 &&
+        !(s_previousAction.sa_flags & SA_SIGINFO) && s_previousAction.sa_handler == SIG_DFL)
+    {
+        action.sa_handler = stackSignalHandler;
+        sigemptyset(&action.sa_mask);
+        action.sa_flags = SA_RESTART;
+        s_stackHandlerInstalled = sigaction(StackSignal, &action, NULL) == 0;
+    }
+    else
+    {
+        qWarning() << "Signal" << StackSignal << "is already handled, stalls are reported without stacks";
+    }
+#endif
+
+    m_heartbeatTimer.setInterval(HeartbeatInterval);
+    connect(&m_heartbeatTimer, SIGNAL(timeout()), this, SLOT(onHeartbeat()));
+    connect(SettingsStore::instance(), SIGNAL(valueChanged(QString,QVariant)), this, SLOT(onSettingChanged(QString,QVariant)));
+}
+
+Watchdog::~Watchdog()
+{
+    stop();
+    wait();
+    qApp->removeEventFilter(this);
+#ifdef SS_WATCHDOG_STACKS
+    // The watchdog thread is gone and this runs on the GUI thread, which has
+    // taken any signal sent to it by now, so nothing can reach the old handler
+    if (s_stackHandlerInstalled)
+    {
+        sigaction(StackSignal, &s_previousAction, NULL);
+        s_stackHandlerInstalled = false;
+    }
+#endif
+    m_instance.storeRelease(NULL);
+}
+
+void Watchdog::watch()
+{
+    if (isRunning())
+        return;
+
+    onHeartbeat();
+    m_heartbeatTimer.start();
+    qApp->installEventFilter(this);
+    start(QThread::LowPriority);
+}
+
+void Watchdog::stop()
+{
+    m_heartbeatTimer.stop();
+    QMutexLocker locker(&m_mutex);
+    m_stop = true;
+    m_wake.wakeOne();
+}
+
+bool Watchdog::enter(const QString& activity)
+{
+    // Metrics::Timer calls this from every thread
+    Watchdog* watchdog = m_instance.loadAcquire();
+    if (!watchdog || QThread::currentThread() != watchdog->thread())
+        return false;
+
+    QMutexLocker locker(&watchdog->m_mutex);
+    watchdog->m_activities.append(activity);
+    return true;
+}
+
+void Watchdog::leave()
+{
+    Watchdog* watchdog = m_instance.loadAcquire();
+    if (!watchdog)
+        return;
+
+    QMutexLocker locker(&watchdog->m_mutex);
+    if (!watchdog->m_activities.isEmpty())
+        watchdog->m_activities.removeLast();
+}
+
+void Watchdog::onHeartbeat()
+{
+    m_heartbeat.store(m_clock.elapsed());
+}
+
+void Watchdog::onSettingChanged(const QString& key, const QVariant& value)
+{
+    if (key == Constants::Settings::SAKURASUITE_STALL_THRESHOLD)
+        m_threshold.store(value.toInt());
+}
+
+bool Watchdog::eventFilter(QObject* object, QEvent* event)
+{
+    // Only remembered, anything more would slow down every event
+    m_receiver.store(object->metaObject());
+    m_eventType.store(event->type());
+    return false;
+}
+
+void Watchdog::run()
+{
+    qint64 stall = 0;
+    QMutexLocker locker(&m_mutex);
+    while (!m_stop)
+    {
+        m_wake.wait(&m_mutex, HeartbeatInterval);
+        if (m_stop)
+            break;
+
+        // The heartbeat is only refreshed every interval, allow for that
+        qint64 threshold = m_threshold.load();
+        qint64 age = m_clock.elapsed() - m_heartbeat.load() - HeartbeatInterval;
+        if (threshold > 0 && age >= threshold)
+        {
+            if (!stall)
+            {
+                // The GUI thread may need the mutex to get going again
+                locker.unlock();
+                reportStall(age);
+                locker.relock();
+            }
+            stall = qMax(stall, age);
+        }
+        else if (stall)
+        {
+            m_stallTimes->record(stall * 1000);
+            qWarning() << "GUI thread responded again after" << stall << "ms";
+            stall = 0;
+        }
+    }
+}
+
+void Watchdog::reportStall(qint64 msecs)
+{
+    m_stalls->add();
+
+    QStringList activities;
+    {
+        QMutexLocker locker(&m_mutex);
+        activities = m_activities;
+    }
+
+    QString stall = QString("GUI thread has not responded for %1 ms").arg(msecs);
+    if (!activities.isEmpty())
+        stall += QString(" in %1").arg(activities.join(" > "));
+    qWarning() << qPrintable(stall);
+
+    QStringList spans = Tracer::instance()->openSpans(thread());
+    if (!spans.isEmpty())
+        qWarning() << "Open trace spans:" << qPrintable(spans.join(" > "));
+
+    const QMetaObject* receiver = m_receiver.load();
+    if (receiver)
+        qWarning() << "Last event:" << qPrintable(eventName(m_eventType.load())) << "sent to a" << receiver->className();
+
+    QStringList stack = guiThreadStack();
+    if (!stack.isEmpty())
+        qWarning() << qPrintable(QString("GUI thread stack:\n%1").arg(stack.join("\n")));
+}
+
+QStringList Watchdog::guiThreadStack()
+{
+    QStringList stack;
+#ifdef SS_WATCHDOG_STACKS
+    if (!s_stackHandlerInstalled)
+        return stack;
+
+    // Every request ends idle, a late signal from one that timed out finds nothing to do
+    s_stackState.storeRelease(StackRequested);
+    if (pthread_kill(s_guiThread, StackSignal) != 0)
+    {
+        s_stackState.storeRelease(StackIdle);
+        return stack;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    while (s_stackState.loadAcquire() != StackDone)
+    {
+        // Give up, unless the handler is already walking the stack, then it's nearly done
+        if (timer.elapsed() > StackTimeout && s_stackState.testAndSetRelaxed(StackRequested, StackIdle))
+            return stack;
+        QThread::msleep(1);
+    }
+
+    // The first frames are the signal handler and the trampoline into it
+    char** symbols = backtrace_symbols(s_frames, s_frameCount);
+    s_stackState.storeRelease(StackIdle);
+    if (!symbols)
+        return stack;
+
+    for (int i = 2; i < s_frameCount; i++)
+        stack << QString::fromLocal8Bit(symbols[i]);
+    free(symbols);
+#endif
+    return stack;
+}
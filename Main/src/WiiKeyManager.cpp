@@ -1,10 +1,44 @@
 #include <WiiKeyManager.hpp>
-#include <stdio.h>
+#include <SettingsStore.hpp>
 #include <QtEndian>
 #include <QByteArray>
-#include <QSettings>
+#include <QDir>
+#include <QFile>
 #include <QStringList>
 #include <QDebug>
+#include <string.h>
+
+namespace
+{
+// BackupMii v1 keys.bin, every number in it is big endian
+struct Field
+{
+    int offset;
+    int size;
+};
+
+constexpr int   DumpSize    = 0x400;
+constexpr char  DumpMagic[] = "BackupMii v1";
+constexpr Field NgIdField    = {0x124, 0x04};
+constexpr Field NgPrivField  = {0x128, 0x1E};
+constexpr Field NgKeyIdField = {0x208, 0x04};
+constexpr Field NgSigField   = {0x20C, 0x3C};
+
+constexpr bool inDump(const Field& field)
+{
+    return field.offset >= (int)sizeof(DumpMagic) - 1 && field.offset + field.size <= DumpSize;
+}
+
+static_assert(inDump(NgIdField) && inDump(NgPrivField) && inDump(NgKeyIdField) && inDump(NgSigField),
+              "every key must lie inside the dump, after the magic");
+static_assert(NgIdField.size == sizeof(quint32) && NgKeyIdField.size == sizeof(quint32), "IDs are 32 bit");
+}
+
+WiiKeyManager::Keys::Keys()
+    : ngId(0),
+      ngKeyId(0)
+{
+}
 
 WiiKeyManager::WiiKeyManager(MainWindow* mainWindow)
     : m_ngPriv(NULL),
@@ -12,6 +46,7 @@ WiiKeyManager::WiiKeyManager(MainWindow* mainWindow)
       m_macAddr(NULL),
       m_ngId(0),
       m_ngKeyId(0),
+      m_open(false),
       m_mainWindow(mainWindow)
 {
 }
@@ -32,79 +67,123 @@ bool WiiKeyManager::open(const QString& filepath, bool clear)
 
     if (clear)
     {
-        if (m_ngPriv)
-        {
-            delete[] m_ngPriv;
-            m_ngPriv = NULL;
-        }
-
-        if (m_ngSig)
-        {
-            delete[] m_ngSig;
-            m_ngSig = NULL;
-        }
+        delete[] m_ngPriv;
+        m_ngPriv = NULL;
+        delete[] m_ngSig;
+        m_ngSig = NULL;
+        m_ngId = 0;
+        m_ngKeyId = 0;
+    }
 
-        if (m_ngId != 0)
-            m_ngId = 0;
-        if (m_ngKeyId != 0)
-            m_ngKeyId = 0;
+    Keys keys;
+    if (!readDump(filepath, keys))
+    {
+        m_open = false;
+        return false;
     }
 
-    FILE* f = fopen(filepath.toStdString().c_str(), "rb");
+    m_consoles[keys.ngId] = keys;
+    setKeys(keys);
 
-    if (f)
+    qDebug() << "Keys loaded";
+    m_open = true;
+    return true;
+}
+
+int WiiKeyManager::openDirectory(const QString& directory)
+{
+    int loaded = 0;
+    QFileInfoList files = QDir(directory).entryInfoList(QStringList() << "*.bin", QDir::Files, QDir::Name);
+    foreach (const QFileInfo& file, files)
     {
-        fseek(f, 0, SEEK_END);
-        quint32 size = ftell(f);
-        fseek(f, 0, SEEK_SET);
+        Keys keys;
+        if (!readDump(file.absoluteFilePath(), keys))
+            continue;
 
-        if (size != 0x400)
-            return false;
+        m_consoles[keys.ngId] = keys;
+        loaded++;
+    }
 
-        char buf[0x0C + 1];
-        memset(buf, 0, 0x0D);
-        fread(buf, 1, 0x0C, f);
-        if (strcmp(buf, "BackupMii v1"))
-            return false;
+    qDebug() << "Loaded keys of" << loaded << "consoles from" << directory;
+    return loaded;
+}
 
-        if (!m_ngPriv)
-        {
-            m_ngPriv = new char[0x1E];
-            fseek(f, 0x128, SEEK_SET);
-            fread(m_ngPriv, 1, 0x1E, f);
-        }
-        if (!m_ngSig)
-        {
-            m_ngSig = new char[0x3C];
-            fseek(f, 0x20C, SEEK_SET);
-            fread(m_ngSig, 1, 0x3C, f);
-        }
+QList<quint32> WiiKeyManager::consoles() const
+{
+    return m_consoles.keys();
+}
 
-        if (m_ngId == 0)
-        {
-            fseek(f, 0x124, SEEK_SET);
-            fread(&m_ngId, 1, 0x04, f);
-            m_ngId = qFromBigEndian<quint32>(m_ngId);
-        }
+bool WiiKeyManager::selectConsole(quint32 ngId)
+{
+    QMap<quint32, Keys>::const_iterator it = m_consoles.constFind(ngId);
+    if (it == m_consoles.constEnd())
+        return false;
 
-        if (m_ngKeyId == 0)
-        {
-            fseek(f, 0x208, SEEK_SET);
-            fread(&m_ngKeyId, 1,  0x04, f);
-            m_ngKeyId = qFromBigEndian<quint32>(m_ngKeyId);
-        }
-        fclose(f);
+    delete[] m_ngPriv;
+    m_ngPriv = NULL;
+    delete[] m_ngSig;
+    m_ngSig = NULL;
+    m_ngId = 0;
+    m_ngKeyId = 0;
+    setKeys(it.value());
+    m_open = true;
+    return true;
+}
 
-        qDebug() << "Keys loaded";
-        m_open = true;
-        return true;
+bool WiiKeyManager::parseDump(const QByteArray& dump, Keys& keys, QString* error)
+{
+    if (dump.size() != DumpSize)
+    {
+        if (error)
+            *error = QString("Expected %1 bytes, got %2").arg(DumpSize).arg(dump.size());
+        return false;
     }
-    else
+
+    if (memcmp(dump.constData(), DumpMagic, sizeof(DumpMagic) - 1))
     {
-        qWarning() << "File not found" << filepath;
+        if (error)
+            *error = "Not a BackupMii v1 dump";
+        return false;
     }
-    m_open = false;
-    return false;
+
+    const uchar* data = reinterpret_cast<const uchar*>(dump.constData());
+    keys.ngId = qFromBigEndian<quint32>(data + NgIdField.offset);
+    keys.ngKeyId = qFromBigEndian<quint32>(data + NgKeyIdField.offset);
+    keys.ngPriv = dump.mid(NgPrivField.offset, NgPrivField.size);
+    keys.ngSig = dump.mid(NgSigField.offset, NgSigField.size);
+    return true;
+}
+
+bool WiiKeyManager::readDump(const QString& filepath, Keys& keys)
+{
+    QFile file(filepath);
+    if (!file.open(QFile::ReadOnly))
+    {
+        qWarning() << "Unable to open" << filepath << file.errorString();
+        return false;
+    }
+
+    // The whole dump in one read, one more byte tells a larger file apart
+    QString error;
+    if (!parseDump(file.read(DumpSize + 1), keys, &error))
+    {
+        qWarning() << "Unable to load keys from" << filepath << error;
+        return false;
+    }
+
+    return true;
+}
+
+void WiiKeyManager::setKeys(const Keys& keys)
+{
+    if (!m_ngPriv)
+        setNGPriv(keys.ngPriv);
+    if (!m_ngSig)
+        setNGSig(keys.ngSig);
+    if (m_ngId == 0)
+        m_ngId = keys.ngId;
+    if (m_ngKeyId == 0)
+        m_ngKeyId = keys.ngKeyId;
 }
 
 bool WiiKeyManager::loadKeys()
@@ -112,12 +191,12 @@ bool WiiKeyManager::loadKeys()
     QByteArray tmp;
     bool ok = false;
 
-    QSettings settings;
+    SettingsStore* settings = SettingsStore::instance();
 
-    if (settings.allKeys().count() <= 0)
+    if (settings->allKeys().count() <= 0)
         return false;
 
-    tmp = QByteArray::fromHex(settings.value("NGID").toByteArray());
+    tmp = QByteArray::fromHex(settings->value("NGID").toByteArray());
     if (tmp.size() == 4 && !tmp.isEmpty())
     {
         m_ngId = tmp.toHex().toInt(&ok, 16);
@@ -135,7 +214,7 @@ bool WiiKeyManager::loadKeys()
         qWarning() << "NGID Not found";
     }
 
-    tmp = QByteArray::fromHex(settings.value("NGKeyID").toByteArray());
+    tmp = QByteArray::fromHex(settings->value("NGKeyID").toByteArray());
     if (tmp.size() == 4 && !tmp.isEmpty())
     {
         m_ngKeyId = tmp.toHex().toInt(&ok, 16);
@@ -152,7 +231,7 @@ bool WiiKeyManager::loadKeys()
         m_ngKeyId = 0;
         qWarning() << "NGKeyID Not found";
     }
-    tmp = QByteArray::fromHex(settings.value("NGPriv").toByteArray());
+    tmp = QByteArray::fromHex(settings->value("NGPriv").toByteArray());
     if (tmp.size() == 30 && !tmp.isEmpty())
     {
         setNGPriv(tmp);
@@ -166,7 +245,7 @@ bool WiiKeyManager::loadKeys()
         qWarning() << "NGPriv Not found";
     }
 
-    tmp = QByteArray::fromHex(settings.value("NGSig").toByteArray());
+    tmp = QByteArray::fromHex(settings->value("NGSig").toByteArray());
     if (tmp.size() == 60 && !tmp.isEmpty())
     {
         setNGSig(tmp);
@@ -179,7 +258,7 @@ bool WiiKeyManager::loadKeys()
         m_ngSig = NULL;
         qWarning() << "NGSig Not found";
     }
-    tmp = QByteArray::fromHex(settings.value("WiiMAC").toByteArray());
+    tmp = QByteArray::fromHex(settings->value("WiiMAC").toByteArray());
     if (tmp.size() == 6 && !tmp.isEmpty())
     {
         setMacAddr(tmp);
@@ -194,7 +273,16 @@ bool WiiKeyManager::loadKeys()
     }
 
     if (m_ngId > 0 && m_ngKeyId > 0 && m_ngPriv != NULL && m_ngSig != NULL && m_macAddr != NULL)
+    {
+        // So the console can be selected again after another one was
+        Keys keys;
+        keys.ngId = m_ngId;
+        keys.ngKeyId = m_ngKeyId;
+        keys.ngPriv = ngPriv();
+        keys.ngSig = ngSig();
+        m_consoles[m_ngId] = keys;
         return m_open = true;
+    }
 
     return false;
 }
@@ -202,14 +290,14 @@ bool WiiKeyManager::loadKeys()
 void WiiKeyManager::saveKeys()
 {
     QByteArray tmp;
-    QSettings settings;
+    SettingsStore* settings = SettingsStore::instance();
     tmp = QByteArray::fromHex(QString::number(m_ngId, 16).toStdString().c_str());
-    settings.setValue("NGID", (tmp.size() == 4 ? tmp.toHex() : QByteArray()));
+    settings->setValue("NGID", (tmp.size() == 4 ? tmp.toHex() : QByteArray()));
     tmp = QByteArray::fromHex(QString::number(m_ngKeyId, 16).toStdString().c_str());
-    settings.setValue("NGKeyID", (tmp.size() == 4 ? tmp.toHex() : QByteArray()));
-    settings.setValue("NGSig",  QByteArray(m_ngSig, 0x3C).toHex());
-    settings.setValue("NGPriv", QByteArray(m_ngPriv, 0x1E).toHex());
-    settings.setValue("WiiMAC", QByteArray(m_macAddr, 0x06).toHex());
+    settings->setValue("NGKeyID", (tmp.size() == 4 ? tmp.toHex() : QByteArray()));
+    settings->setValue("NGSig",  QByteArray(m_ngSig, 0x3C).toHex());
+    settings->setValue("NGPriv", QByteArray(m_ngPriv, 0x1E).toHex());
+    settings->setValue("WiiMAC", QByteArray(m_macAddr, 0x06).toHex());
 }
 
 bool WiiKeyManager::isOpen() const
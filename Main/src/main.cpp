@@ -15,7 +15,13 @@
 
 #include "MainWindow.hpp"
 #include <QApplication>
+#include <QMessageBox>
 #include <ApplicationLog.hpp>
+#include <SingleInstance.hpp>
+#include <StartupProfile.hpp>
+#include <Tracer.hpp>
+#include <Watchdog.hpp>
+#include <AllocationProfiler.hpp>
 #ifdef Q_OS_WIN
 #include <QCommandLineParser>
 #include <QCommandLineOption>
@@ -30,35 +36,84 @@
 
 void messageHander(QtMsgType type, const QMessageLogContext& context, const QString &msg)
 {
-    QString formattedMsg = QString("[%1(%2) %3]: %4").arg(context.file).arg(context.line).arg(context.function).arg(msg);
+    // The source location is interned by the log and only formatted when shown.
+    // Levels disabled with the "logLevels" setting never get here, see LogFilter.
     switch(type)
     {
         case QtDebugMsg:
-            ApplicationLog::instance()->debug(formattedMsg);
+            ApplicationLog::instance()->addMessage(ApplicationLog::Debug, context, msg);
             break;
         case QtWarningMsg:
-            ApplicationLog::instance()->warning(formattedMsg);
+            ApplicationLog::instance()->addMessage(ApplicationLog::Warning, context, msg);
             break;
         case QtCriticalMsg:
-            ApplicationLog::instance()->error(formattedMsg);
+            ApplicationLog::instance()->addMessage(ApplicationLog::Error, context, msg);
             break;
         case QtFatalMsg:
-            ApplicationLog::instance()->fatal(formattedMsg);
+            ApplicationLog::instance()->addMessage(ApplicationLog::Fatal, context, msg);
             break;
     }
 }
 
+// Anything that isn't an option is a file to open
+QStringList fileArguments(int argc, char* argv[])
+{
+    QStringList files;
+    for (int i = 1; i < argc; i++)
+    {
+        QString arg = QString::fromLocal8Bit(argv[i]);
+        if (!arg.startsWith('-'))
+            files << arg;
+        else if (arg.endsWith("icon-theme"))
+            i++;
+    }
+
+    return files;
+}
+
 int main(int argc, char *argv[])
 {
+    const qint64 started = StartupProfile::now();
     try
     {
+        // QSettings needs these before the application object exists
+        QCoreApplication::setOrganizationName("org.wiiking2.com");
+        QCoreApplication::setOrganizationDomain("http://wiiking2.com");
+        QCoreApplication::setApplicationName(Constants::SAKURASUITE_APP_NAME);
+#ifdef Q_OS_WIN
+        // This is unnecessary on any platform but Windows
+        QSettings::setDefaultFormat(QSettings::IniFormat);
+#endif
+
         QApplication a(argc, argv);
+        QStringList files = fileArguments(argc, argv);
+        SingleInstance singleInstance;
+        bool isSingleInstance = false;
+#ifndef SS_DEBUG
+        // If another instance is running, hand it our files and leave
+        // before paying for MainWindow and the plugins
+        isSingleInstance = QSettings().value(Constants::Settings::SAKURASUITE_SINGLE_INSTANCE, false).toBool();
+        if (isSingleInstance && !singleInstance.tryLock())
+        {
+            if (singleInstance.forward(files))
+                return 0;
+
+            QMessageBox::critical(NULL, Constants::SAKURASUITE_INSTANCE_EXISTS, Constants::SAKURASUITE_INSTANCE_EXISTS_MSG);
+            return 1;
+        }
+#endif
+
+        // SAKURASUITE_STARTUP_PROFILE=<file> records the startup milestones and quits once idle
+        StartupProfile::instance()->mark("main", started);
+        StartupProfile::instance()->mark("application");
+        // Create the tracer and the log on this thread before any other thread can use them
+        // SAKURASUITE_TRACE=<file> records a trace from startup on and saves it on exit
+        QString traceFile = QString::fromLocal8Bit(qgetenv("SAKURASUITE_TRACE"));
+        Tracer::instance()->setEnabled(!traceFile.isEmpty());
+        ApplicationLog::instance();
         qInstallMessageHandler(messageHander);
         qDebug() << "Starting...";
         a.setLibraryPaths(QStringList() << a.libraryPaths() << "plugins");
-        a.setOrganizationName("org.wiiking2.com");
-        a.setOrganizationDomain("http://wiiking2.com");
-        a.setApplicationName(Constants::SAKURASUITE_APP_NAME);
         a.setApplicationVersion(Constants::SAKURASUITE_APP_VERSION);
         a.setWindowIcon(QIcon(":/about/SakuraSuite.png"));
 
@@ -73,8 +128,6 @@ int main(int argc, char *argv[])
                                          .arg(Constants::SAKURASUITE_TITLE)
                                          .arg(Constants::SAKURASUITE_APP_VERSION));
         QCommandLineOption helpOption = parser.addHelpOption();
-        // This is unnecessary on any platform but Windows
-        QSettings::setDefaultFormat(QSettings::IniFormat);
         iconThemeOption.setDefaultValue("oxygen");
         parser.process(a);
 
@@ -102,10 +155,34 @@ int main(int argc, char *argv[])
         a.installTranslator(&appTranslator);
         qDebug() << "Creating MainWindow...";
         MainWindow w;
+        StartupProfile::instance()->mark("mainWindow");
+
+        if (isSingleInstance)
+        {
+            QObject::connect(&singleInstance, SIGNAL(filesReceived(QStringList)), &w, SLOT(openFiles(QStringList)));
+            singleInstance.listen();
+        }
 
         w.show();
+        w.openFiles(files);
+
+        // Started last so loading the plugins doesn't count as a stall
+        Watchdog::instance()->watch();
+        StartupProfile::instance()->finishOnIdle();
+        int ret = a.exec();
+        if (AllocationProfiler::isEnabled())
+        {
+            foreach (const QString& line, AllocationProfiler::report().split('\n'))
+                qDebug() << qPrintable(line);
+        }
+        if (!traceFile.isEmpty())
+        {
+            QString error;
+            if (!Tracer::instance()->save(traceFile, &error))
+                qWarning() << "Unable to save trace" << traceFile << error;
+        }
 
-        return a.exec();
+        return ret;
     }
     catch(...)
     {
@@ -0,0 +1,171 @@
+// This file is part of Sakura Suite.
+//
+// Sakura Suite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sakura Suite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Sakura Suite.  If not, see <http://www.gnu.org/licenses/>
+
+
+// sakurasuite_crypto_test, run by ctest. Checks WiiCrypto's known answers
+// through the public functions with the portable kernels and again with the
+// accelerated ones where the CPU has them, runs selfTest(), and compares both
+// on buffers processed whole and in pieces. Exits with 1 on the first failure.
+
+#include "WiiCrypto.hpp"
+#include <QByteArray>
+#include <QString>
+#include <stdio.h>
+
+namespace
+{
+int failures = 0;
+
+void check(bool passed, const QString& what)
+{
+    if (!passed)
+    {
+        fprintf(stderr, "FAIL %s\n", qPrintable(what));
+        failures++;
+    }
+}
+
+QByteArray sha1(const QByteArray& data)
+{
+    quint8 digest[WiiCrypto::Sha1Size];
+    WiiCrypto::sha1(data.constData(), data.size(), digest);
+    return QByteArray((const char*)digest, sizeof(digest));
+}
+
+QByteArray encrypt(const QByteArray& key, QByteArray iv, const QByteArray& data)
+{
+    QByteArray output(data.size(), '\0');
+    WiiCrypto::aesCbcEncrypt((const quint8*)key.constData(), (quint8*)iv.data(), (const quint8*)data.constData(),
+                             (quint8*)output.data(), data.size());
+    return output;
+}
+
+QByteArray decrypt(const QByteArray& key, QByteArray iv, const QByteArray& data)
+{
+    QByteArray output(data.size(), '\0');
+    WiiCrypto::aesCbcDecrypt((const quint8*)key.constData(), (quint8*)iv.data(), (const quint8*)data.constData(),
+                             (quint8*)output.data(), data.size());
+    return output;
+}
+
+// SP 800-38A F.2.1 and FIPS 180 / RFC 3174
+void checkKnownAnswers(const QString& kernels)
+{
+    const QByteArray key = QByteArray::fromHex("2b7e151628aed2a6abf7158809cf4f3c");
+    const QByteArray iv = QByteArray::fromHex("000102030405060708090a0b0c0d0e0f");
+    const QByteArray plain = QByteArray::fromHex("6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51"
+                                                 "30c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710");
+    const QByteArray cipher = QByteArray::fromHex("7649abac8119b246cee98e9b12e9197d5086cb9b507219ee95db113a917678b2"
+                                                  "73bed6b8e3c1743b7116e69e222295163ff1caa1681fac09120eca307586e1a7");
+    check(encrypt(key, iv, plain) == cipher, kernels + ": AES-CBC encryption of SP 800-38A F.2.1");
+    check(decrypt(key, iv, cipher) == plain, kernels + ": AES-CBC decryption of SP 800-38A F.2.1");
+
+    // In place, as the header allows
+    QByteArray inPlace = cipher;
+    QByteArray chain = iv;
+    WiiCrypto::aesCbcDecrypt((const quint8*)key.constData(), (quint8*)chain.data(), (const quint8*)inPlace.constData(),
+                             (quint8*)inPlace.data(), inPlace.size());
+    check(inPlace == plain, kernels + ": in place AES-CBC decryption");
+    check(chain == cipher.right(WiiCrypto::AesBlockSize), kernels + ": IV after decryption is the last cipher block");
+
+    check(sha1(QByteArray()).toHex() == "da39a3ee5e6b4b0d3255bfef95601890afd80709", kernels + ": SHA-1 of nothing");
+    check(sha1("abc").toHex() == "a9993e364706816aba3e25717850c26c9cd0d89d", kernels + ": SHA-1 of abc");
+    check(sha1("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq").toHex() == "84983e441c3bd26ebaae4aa1f95129e5e54670f1",
+          kernels + ": SHA-1 of the two block message");
+    check(sha1(QByteArray(1000000, 'a')).toHex() == "34aa973cd4c4daa4f61eeb2bdbad27316534016f", kernels + ": SHA-1 of a million a");
+}
+
+struct Results
+{
+    QByteArray whole;
+    QByteArray pieces;
+    QByteArray decrypted;
+};
+
+// Lengths that aren't a multiple of the four block interleave, in pieces of uneven size
+Results run(const QByteArray& key, const QByteArray& data)
+{
+    const QByteArray iv(WiiCrypto::AesBlockSize, '\x5a');
+    Results results;
+    results.whole = encrypt(key, iv, data);
+
+    results.pieces.resize(data.size());
+    QByteArray chain = iv;
+    int offset = 0;
+    for (int blocks = 1; offset < data.size(); blocks = blocks % 7 + 1)
+    {
+        const int size = qMin(blocks * (int)WiiCrypto::AesBlockSize, data.size() - offset);
+        WiiCrypto::aesCbcEncrypt((const quint8*)key.constData(), (quint8*)chain.data(), (const quint8*)data.constData() + offset,
+                                 (quint8*)results.pieces.data() + offset, size);
+        offset += size;
+    }
+
+    results.decrypted = decrypt(key, iv, results.whole);
+    return results;
+}
+}
+
+int main()
+{
+    QString error;
+    check(WiiCrypto::selfTest(&error), "selfTest: " + error);
+
+    const bool accelerated = WiiCrypto::isAesAccelerated() || WiiCrypto::isShaAccelerated();
+    WiiCrypto::setAccelerationEnabled(false);
+    checkKnownAnswers(WiiCrypto::kernels());
+    if (accelerated)
+    {
+        WiiCrypto::setAccelerationEnabled(true);
+        checkKnownAnswers(WiiCrypto::kernels());
+    }
+    else
+    {
+        printf("No accelerated kernels on this CPU, only the portable ones were checked\n");
+    }
+
+    const QByteArray key = QByteArray::fromHex("000102030405060708090a0b0c0d0e0f");
+    for (int blocks = 0; blocks <= 37; blocks++)
+    {
+        QByteArray data(blocks * WiiCrypto::AesBlockSize + blocks % 5, '\0');
+        for (int i = 0; i < data.size(); i++)
+            data[i] = (char)(i * 31 + blocks);
+        // SHA-1 takes any length, AES only whole blocks
+        const QByteArray blocksOnly = data.left(blocks * WiiCrypto::AesBlockSize);
+
+        WiiCrypto::setAccelerationEnabled(false);
+        const Results portable = run(key, blocksOnly);
+        const QByteArray portableDigest = sha1(data);
+        WiiCrypto::setAccelerationEnabled(true);
+        const Results current = run(key, blocksOnly);
+        const QByteArray currentDigest = sha1(data);
+
+        const QString size = QString("%1 bytes").arg(data.size());
+        check(portable.pieces == portable.whole, "portable: AES-CBC in pieces of " + size);
+        check(portable.decrypted == blocksOnly, "portable: AES-CBC round trip of " + size);
+        check(current.whole == portable.whole, WiiCrypto::kernels() + ": AES-CBC encryption matches portable on " + size);
+        check(current.pieces == portable.whole, WiiCrypto::kernels() + ": AES-CBC in pieces matches portable on " + size);
+        check(current.decrypted == blocksOnly, WiiCrypto::kernels() + ": AES-CBC round trip of " + size);
+        check(currentDigest == portableDigest, WiiCrypto::kernels() + ": SHA-1 matches portable on " + size);
+    }
+
+    if (failures)
+    {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+
+    printf("All checks passed with %s\n", qPrintable(WiiCrypto::kernels()));
+    return 0;
+}